@@ -1,6 +1,7 @@
 #include <vector>
 #include "Blades.h"
 #include "BufferUtils.h"
+#include "SceneSnapshot.h"
 
 static std::array<glm::vec2, 15> bladeVertexData =
 {
@@ -38,115 +39,134 @@ static std::array<uint32_t, 39> bladeIndexData =
     12, 13, 14
 };
 
-glm::vec4 getNearestClumpGrid(glm::vec2 position) {
-	glm::ivec2 clumpGridID = glm::floor(position / ClumpGridSize);
-	float minDist = 1000000.0f;
-    glm::vec4 out;
-    for (int i = -1; i <= 1; i++) {
-        for (int j = -1; j <= 1; j++) {
-			glm::vec2 currGrid = clumpGridID + glm::ivec2(i, j);
-            glm::vec2 gridOffset = hash22(currGrid) * ClumpGridSize;
-			glm::vec2 gridCenter = currGrid * ClumpGridSize + gridOffset;
-			float dist = glm::distance(position, gridCenter);
-            if (dist < minDist) {
-                minDist = dist;
-                out = glm::vec4(currGrid, gridCenter);
-            }
-        }
-    }
-	return out;
+// Derive a stable per-tile seed from the tile offset
+static uint32_t tileSeed(glm::vec3 offset) {
+    int32_t x = static_cast<int32_t>(glm::floor(offset.x));
+    int32_t z = static_cast<int32_t>(glm::floor(offset.z));
+    uint32_t h = static_cast<uint32_t>(x) * 0x8da6b343u ^ static_cast<uint32_t>(z) * 0xd8163841u;
+    h ^= h >> 16;
+    h *= 0x7feb352du;
+    h ^= h >> 15;
+    return h;
 }
 
-#define USE_CLUMP 1
 
+Blades::Blades(Device* device, VkCommandPool commandPool, float planeDim, const std::vector<glm::vec3>& tileOffsets, const GrassSettings& settings, const SceneSnapshot* snapshot) : Model(device, commandPool, {}, {}),
+    bladesPerTile(settings.bladesPerTile) {
+    const uint32_t tileCount = static_cast<uint32_t>(tileOffsets.size());
+    const uint32_t bladeCount = tileCount * bladesPerTile;
+
+    generationParams.resize(tileCount);
+    for (uint32_t t = 0; t < tileCount; ++t) {
+        generationParams[t].offset = glm::vec4(tileOffsets[t], planeDim);
+        generationParams[t].seed = tileSeed(tileOffsets[t]);
+        generationParams[t].bladeCount = bladesPerTile;
+        generationParams[t].firstBlade = t * bladesPerTile;
+        generationParams[t].useClump = settings.useClump ? 1 : 0;
+        generationParams[t].heightRange = glm::vec2(settings.shape.minHeight, settings.shape.maxHeight);
+        generationParams[t].widthRange = glm::vec2(settings.shape.minWidth, settings.shape.maxWidth);
+        generationParams[t].bendRange = glm::vec2(settings.shape.minBend, settings.shape.maxBend);
+    }
 
-Blades::Blades(Device* device, VkCommandPool commandPool, float planeDim, glm::vec3 offset) : Model(device, commandPool, {}, {}) {
-    std::vector<Blade> blades;
-    blades.reserve(NUM_BLADES);
+    // Transfer source so a snapshot can read them back
+    const VkBufferUsageFlags bladeUsage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
 
-    for (int i = 0; i < NUM_BLADES; i++) {
-        Blade currentBlade = Blade();
+    if (snapshot != nullptr && snapshot->GetGrassCount() == bladeCount) {
+        // Staged straight from the mapping, nothing to generate
+        BufferUtils::CreateBufferFromBlobs(device, commandPool, { std::make_pair(static_cast<const void*>(snapshot->GetGrassStatic()), VkDeviceSize(bladeCount) * sizeof(BladeStatic)) }, bladeUsage, bladesStaticBuffer, bladesStaticBufferMemory);
+        BufferUtils::CreateBufferFromBlobs(device, commandPool, { std::make_pair(static_cast<const void*>(snapshot->GetGrassDynamic()), VkDeviceSize(bladeCount) * sizeof(BladeDynamic)) }, bladeUsage, bladesDynamicBuffer, bladesDynamicBufferMemory);
+    }
+    else {
+#if GPU_BLADE_GENERATION
+        // Blades are written by the generation kernel, so no staging upload is needed
+        BufferUtils::CreateBuffer(device, bladeCount * sizeof(BladeStatic), bladeUsage, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, bladesStaticBuffer, bladesStaticBufferMemory);
+        BufferUtils::CreateBuffer(device, bladeCount * sizeof(BladeDynamic), bladeUsage, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, bladesDynamicBuffer, bladesDynamicBufferMemory);
+        needsGeneration = true;
+#else
+        std::vector<BladeStatic> bladesStatic(bladeCount);
+        std::vector<BladeDynamic> bladesDynamic(bladeCount);
+
+        for (uint32_t t = 0; t < tileCount; ++t) {
+            BladeGeneration::GenerateGrassTile(tileOffsets[t], planeDim, settings, &bladesStatic[t * bladesPerTile], &bladesDynamic[t * bladesPerTile]);
+        }
 
-        glm::vec3 bladeUp(0.0f, 1.0f, 0.0f);
+        BufferUtils::CreateBufferFromData(device, commandPool, bladesStatic.data(), bladeCount * sizeof(BladeStatic), bladeUsage, bladesStaticBuffer, bladesStaticBufferMemory);
+        BufferUtils::CreateBufferFromData(device, commandPool, bladesDynamic.data(), bladeCount * sizeof(BladeDynamic), bladeUsage, bladesDynamicBuffer, bladesDynamicBufferMemory);
+#endif
+    }
 
-        // Generate positions and direction (v0)
-        float x = (generateRandomFloat() - 0.5f) * planeDim;
-        float y = 0.0f;
-        float z = (generateRandomFloat() - 0.5f) * planeDim;
-        float direction = generateRandomFloat() * 2.f * 3.14159265f;
-        glm::vec3 bladePosition(x, y, z);
-        bladePosition += offset;
-		glm::vec2 bladeXZPosition(bladePosition.x, bladePosition.z);
-		glm::vec4 clumpData = getNearestClumpGrid(bladeXZPosition);
-		float distToCenter = glm::distance(bladeXZPosition, glm::vec2(clumpData.z, clumpData.w));
+    // One command per tile, each draws from its own range of the culled list
+    std::vector<BladeDrawIndirect> indirectDraws(tileCount);
+    for (uint32_t t = 0; t < tileCount; ++t) {
+        indirectDraws[t].indexCount = bladeIndexData.size();
+        indirectDraws[t].instanceCount = 0;
+        indirectDraws[t].firstIndex = 0;
+        indirectDraws[t].vertexOffset = 0;
+        indirectDraws[t].firstInstance = t * bladesPerTile;
+    }
 
-#if USE_CLUMP
-        // shift to clump center a little bit
-		bladeXZPosition = glm::mix(bladeXZPosition, glm::vec2(clumpData.z, clumpData.w), 0.01f);
-		bladePosition.x = bladeXZPosition.x;
-		bladePosition.z = bladeXZPosition.y;
-		bladePosition.y += terrainHeight(bladeXZPosition);
+    // Culling writes the 16-bit indices of the visible blades, only the GPU touches them
+    BufferUtils::CreateBuffer(device, BladePacking::CulledIndexListSize(bladeCount), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, culledBladesBuffer, culledBladesBufferMemory);
+    BufferUtils::CreateBufferFromData(device, commandPool, indirectDraws.data(), indirectDraws.size() * sizeof(BladeDrawIndirect), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, numBladesBuffer, numBladesBufferMemory);
+    BufferUtils::CreateBufferFromData(device, commandPool, indirectDraws.data(), indirectDraws.size() * sizeof(BladeDrawIndirect), VK_BUFFER_USAGE_TRANSFER_SRC_BIT, numBladesResetBuffer, numBladesResetBufferMemory);
+}
 
-        // face to the same direction
-		float clumpDir = hash32(glm::vec3(clumpData.x, clumpData.y, 0.6f)).x * 2.f * 3.14159265f;
-        direction = glm::mix(direction, clumpDir, 0.6f);
+VkBuffer Blades::GetBladesStaticBuffer() const {
+    return bladesStaticBuffer;
+}
 
-        // face off to center
-		float offCenterDir = std::atan2(bladePosition.z - clumpData.w, bladePosition.x - clumpData.z) + 0.5f * 3.14159265f;
-		direction = glm::mix(direction, offCenterDir, 0.4f);
-#endif
-        currentBlade.v0 = glm::vec4(bladePosition, direction);
+VkBuffer Blades::GetBladesDynamicBuffer() const {
+    return bladesDynamicBuffer;
+}
 
-        // Bezier point and height (v1)
-        float height = MIN_HEIGHT + (generateRandomFloat() * (MAX_HEIGHT - MIN_HEIGHT)) + 6.f * glm::exp(-0.3f * distToCenter);
-        currentBlade.v1 = glm::vec4(bladePosition + bladeUp * height, height);
+VkBuffer Blades::GetCulledBladesBuffer() const {
+    return culledBladesBuffer;
+}
 
-        // Physical model guide and width (v2)
-        float width = MIN_WIDTH + (generateRandomFloat() * (MAX_WIDTH - MIN_WIDTH));
-        currentBlade.v2 = glm::vec4(bladePosition + bladeUp * height, width);
+VkBuffer Blades::GetNumBladesBuffer() const {
+    return numBladesBuffer;
+}
 
-        // Up vector and stiffness coefficient (up)
-        float stiffness = MIN_BEND + (generateRandomFloat() * (MAX_BEND - MIN_BEND));
-        currentBlade.up = glm::vec4(bladeUp, stiffness);
+VkBuffer Blades::GetNumBladesResetBuffer() const {
+    return numBladesResetBuffer;
+}
 
-        blades.push_back(currentBlade);
-    }
+uint32_t Blades::GetTileCount() const {
+    return static_cast<uint32_t>(generationParams.size());
+}
 
-    BladeDrawIndirect indirectDraw;
-    /*indirectDraw.vertexCount = NUM_BLADES;
-    indirectDraw.instanceCount = 1;
-    indirectDraw.firstVertex = 0;
-    indirectDraw.firstInstance = 0;*/
-	indirectDraw.indexCount = bladeIndexData.size();
-	indirectDraw.instanceCount = NUM_BLADES;
-	indirectDraw.firstIndex = 0;
-	indirectDraw.vertexOffset = 0;
-	indirectDraw.firstInstance = 0;
-
-    BufferUtils::CreateBufferFromData(device, commandPool, blades.data(), NUM_BLADES * sizeof(Blade), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, bladesBuffer, bladesBufferMemory);
-    BufferUtils::CreateBuffer(device, NUM_BLADES * sizeof(Blade), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT, culledBladesBuffer, culledBladesBufferMemory);
-    BufferUtils::CreateBufferFromData(device, commandPool, &indirectDraw, sizeof(BladeDrawIndirect), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT, numBladesBuffer, numBladesBufferMemory);
+uint32_t Blades::GetBladesPerTile() const {
+    return bladesPerTile;
 }
 
-VkBuffer Blades::GetBladesBuffer() const {
-    return bladesBuffer;
+const std::vector<BladeGenerationParams>& Blades::GetGenerationParams() const {
+    return generationParams;
 }
 
-VkBuffer Blades::GetCulledBladesBuffer() const {
-    return culledBladesBuffer;
+bool Blades::NeedsGeneration() const {
+    return needsGeneration;
 }
 
-VkBuffer Blades::GetNumBladesBuffer() const {
-    return numBladesBuffer;
+void Blades::MarkGenerated() {
+    needsGeneration = false;
 }
 
 Blades::~Blades() {
-    vkDestroyBuffer(device->GetVkDevice(), bladesBuffer, nullptr);
-    vkFreeMemory(device->GetVkDevice(), bladesBufferMemory, nullptr);
+    vkDestroyBuffer(device->GetVkDevice(), bladesStaticBuffer, nullptr);
+    device->RecordFree(bladesStaticBufferMemory);
+    vkFreeMemory(device->GetVkDevice(), bladesStaticBufferMemory, nullptr);
+    vkDestroyBuffer(device->GetVkDevice(), bladesDynamicBuffer, nullptr);
+    device->RecordFree(bladesDynamicBufferMemory);
+    vkFreeMemory(device->GetVkDevice(), bladesDynamicBufferMemory, nullptr);
     vkDestroyBuffer(device->GetVkDevice(), culledBladesBuffer, nullptr);
+    device->RecordFree(culledBladesBufferMemory);
     vkFreeMemory(device->GetVkDevice(), culledBladesBufferMemory, nullptr);
     vkDestroyBuffer(device->GetVkDevice(), numBladesBuffer, nullptr);
+    device->RecordFree(numBladesBufferMemory);
     vkFreeMemory(device->GetVkDevice(), numBladesBufferMemory, nullptr);
+    vkDestroyBuffer(device->GetVkDevice(), numBladesResetBuffer, nullptr);
+    device->RecordFree(numBladesResetBufferMemory);
+    vkFreeMemory(device->GetVkDevice(), numBladesResetBufferMemory, nullptr);
 }
 
 VkBuffer Blade::bladeVertexBuffer = 0;
@@ -165,7 +185,9 @@ void Blade::CreateBladeVertexIndexBuffer(Device* device, VkCommandPool commandPo
 void Blade::DestroyBladeVertexIndexBuffer(Device* device)
 {
 	vkDestroyBuffer(device->GetVkDevice(), bladeVertexBuffer, nullptr);
+	device->RecordFree(bladeVertexBufferMemory);
 	vkFreeMemory(device->GetVkDevice(), bladeVertexBufferMemory, nullptr);
 	vkDestroyBuffer(device->GetVkDevice(), bladeIndexBuffer, nullptr);
+	device->RecordFree(bladeIndexBufferMemory);
 	vkFreeMemory(device->GetVkDevice(), bladeIndexBufferMemory, nullptr);
 }
@@ -2,64 +2,63 @@
 #include <vulkan/vulkan.h>
 #include <glm/glm.hpp>
 #include <array>
+#include <vector>
 #include "Model.h"
+#include "BladePacking.h"
+#include "BladeGeneration.h"
 
-constexpr static unsigned int NUM_BLADES = 1 << 8;
-constexpr static float MIN_HEIGHT = 6.3f;
-constexpr static float MAX_HEIGHT = 8.5f;
-constexpr static float MIN_WIDTH = 0.28f;
-constexpr static float MAX_WIDTH = 0.32f;
-constexpr static float MIN_BEND = 1.5f;
-constexpr static float MAX_BEND = 2.5f;
 
-constexpr static float ClumpGridSize = 10.0f;
+// Generate blades with shaders/generate.comp instead of uploading them from the CPU
+#define GPU_BLADE_GENERATION 1
 
 
 struct Blade {
-    // Position and direction
-    glm::vec4 v0;
-    // Bezier point and height
-    glm::vec4 v1;
-    // Physical model guide and width
-    glm::vec4 v2;
-    // Up vector and stiffness coefficient
-    glm::vec4 up;
-
-    static VkVertexInputBindingDescription getBindingDescription() {
-        VkVertexInputBindingDescription bindingDescription = {};
-        bindingDescription.binding = 0;
-        bindingDescription.stride = sizeof(Blade);
-        bindingDescription.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
-
-        return bindingDescription;
+    // Binding 0 reads BladeStatic, binding 1 reads BladeDynamic
+    static std::array<VkVertexInputBindingDescription, 2> getBindingDescriptions() {
+        std::array<VkVertexInputBindingDescription, 2> bindingDescriptions = {};
+        bindingDescriptions[0].binding = 0;
+        bindingDescriptions[0].stride = sizeof(BladeStatic);
+        bindingDescriptions[0].inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+
+        bindingDescriptions[1].binding = 1;
+        bindingDescriptions[1].stride = sizeof(BladeDynamic);
+        bindingDescriptions[1].inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+
+        return bindingDescriptions;
     }
 
-    static std::array<VkVertexInputAttributeDescription, 4> getAttributeDescriptions() {
-        std::array<VkVertexInputAttributeDescription, 4> attributeDescriptions = {};
+    static std::array<VkVertexInputAttributeDescription, 5> getAttributeDescriptions() {
+        std::array<VkVertexInputAttributeDescription, 5> attributeDescriptions = {};
 
         // v0
         attributeDescriptions[0].binding = 0;
         attributeDescriptions[0].location = 0;
-        attributeDescriptions[0].format = VK_FORMAT_R32G32B32A32_SFLOAT;
-        attributeDescriptions[0].offset = offsetof(Blade, v0);
+        attributeDescriptions[0].format = VK_FORMAT_R32G32B32_SFLOAT;
+        attributeDescriptions[0].offset = offsetof(BladeStatic, v0);
 
-        // v1
+        // direction and height
         attributeDescriptions[1].binding = 0;
         attributeDescriptions[1].location = 1;
-        attributeDescriptions[1].format = VK_FORMAT_R32G32B32A32_SFLOAT;
-        attributeDescriptions[1].offset = offsetof(Blade, v1);
+        attributeDescriptions[1].format = VK_FORMAT_R16G16_SFLOAT;
+        attributeDescriptions[1].offset = offsetof(BladeStatic, dirHeight);
 
-        // v2
+        // width and stiffness
         attributeDescriptions[2].binding = 0;
         attributeDescriptions[2].location = 2;
-        attributeDescriptions[2].format = VK_FORMAT_R32G32B32A32_SFLOAT;
-        attributeDescriptions[2].offset = offsetof(Blade, v2);
+        attributeDescriptions[2].format = VK_FORMAT_R16G16_SFLOAT;
+        attributeDescriptions[2].offset = offsetof(BladeStatic, widthStiffness);
 
-        // up
-        attributeDescriptions[3].binding = 0;
+        // v1 - v0 and (v2 - v0).x
+        attributeDescriptions[3].binding = 1;
         attributeDescriptions[3].location = 3;
-        attributeDescriptions[3].format = VK_FORMAT_R32G32B32A32_SFLOAT;
-        attributeDescriptions[3].offset = offsetof(Blade, up);
+        attributeDescriptions[3].format = VK_FORMAT_R16G16B16A16_SNORM;
+        attributeDescriptions[3].offset = offsetof(BladeDynamic, bezier);
+
+        // (v2 - v0).yz
+        attributeDescriptions[4].binding = 1;
+        attributeDescriptions[4].location = 4;
+        attributeDescriptions[4].format = VK_FORMAT_R16G16_SNORM;
+        attributeDescriptions[4].offset = offsetof(BladeDynamic, bezier) + 2 * sizeof(uint32_t);
 
         return attributeDescriptions;
     }
@@ -91,20 +90,73 @@ struct BladeDrawIndirect {
     uint32_t    firstInstance;
 };
 
+// Push constants of shaders/compute.comp
+struct SimulationParams {
+    uint32_t bladeCount;
+    // Culled slots reserved per draw command, each command appends to its own range
+    uint32_t drawCapacity;
+    // Draw commands per variant, selected by projected size
+    uint32_t lodCount;
+    // Culling is skipped unless this bit is set in Theme::visibleMask
+    uint32_t visibilityBit;
+    // Tiles share one set of buffers, tile t owns bladesPerTile blades and drawsPerTile commands
+    uint32_t bladesPerTile;
+    uint32_t drawsPerTile;
+    // Counter of the simulation stats buffer this frame in flight adds to
+    uint32_t statsSlot;
+};
+
+// Push constants of shaders/generate.comp
+struct BladeGenerationParams {
+    // xyz: tile offset, w: plane dimension
+    glm::vec4 offset;
+    uint32_t seed;
+    uint32_t bladeCount;
+    // Index of the tile's first blade in the shared buffers
+    uint32_t firstBlade;
+    uint32_t useClump;
+    // min, max of each attribute
+    glm::vec2 heightRange;
+    glm::vec2 widthRange;
+    glm::vec2 bendRange;
+};
+
+class SceneSnapshot;
+
+// Every grass tile lives in the same buffers so a pass binds them once.
+// Tile t owns blades [t * bladesPerTile, (t + 1) * bladesPerTile), culled slots in the same range and draw command t
 class Blades : public Model {
 private:
-    VkBuffer bladesBuffer;
+    uint32_t bladesPerTile;
+    std::vector<BladeGenerationParams> generationParams;
+    bool needsGeneration = false;
+
+    VkBuffer bladesStaticBuffer;
+    VkBuffer bladesDynamicBuffer;
     VkBuffer culledBladesBuffer;
     VkBuffer numBladesBuffer;
+    // Draw commands with zero instances, copied over numBladesBuffer before culling
+    VkBuffer numBladesResetBuffer;
 
-    VkDeviceMemory bladesBufferMemory;
+    VkDeviceMemory bladesStaticBufferMemory;
+    VkDeviceMemory bladesDynamicBufferMemory;
     VkDeviceMemory culledBladesBufferMemory;
     VkDeviceMemory numBladesBufferMemory;
+    VkDeviceMemory numBladesResetBufferMemory;
 
 public:
-    Blades(Device* device, VkCommandPool commandPool, float planeDim, glm::vec3 offset = glm::vec3(0));
-    VkBuffer GetBladesBuffer() const;
+    // Blades are uploaded from snapshot instead of generated when it holds the right count
+    Blades(Device* device, VkCommandPool commandPool, float planeDim, const std::vector<glm::vec3>& tileOffsets, const GrassSettings& settings, const SceneSnapshot* snapshot = nullptr);
+    VkBuffer GetBladesStaticBuffer() const;
+    VkBuffer GetBladesDynamicBuffer() const;
     VkBuffer GetCulledBladesBuffer() const;
     VkBuffer GetNumBladesBuffer() const;
+    VkBuffer GetNumBladesResetBuffer() const;
+    uint32_t GetTileCount() const;
+    uint32_t GetBladesPerTile() const;
+    // One entry per tile
+    const std::vector<BladeGenerationParams>& GetGenerationParams() const;
+    bool NeedsGeneration() const;
+    void MarkGenerated();
     ~Blades();
 };
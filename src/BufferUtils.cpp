@@ -26,6 +26,7 @@ void BufferUtils::CreateBuffer(Device* device, VkDeviceSize size, VkBufferUsageF
     if (vkAllocateMemory(device->GetVkDevice(), &allocInfo, nullptr, &bufferMemory) != VK_SUCCESS) {
       throw std::runtime_error("Failed to allocate vertex buffer");
     }
+    device->RecordAllocation(bufferMemory, allocInfo.allocationSize);
 
     // Associate allocated memory with vertex buffer
     vkBindBufferMemory(device->GetVkDevice(), buffer, bufferMemory, 0);
@@ -88,5 +89,59 @@ void BufferUtils::CreateBufferFromData(Device* device, VkCommandPool commandPool
 
     // No need for the staging buffer anymore
     vkDestroyBuffer(device->GetVkDevice(), stagingBuffer, nullptr);
+    device->RecordFree(stagingBufferMemory);
+    vkFreeMemory(device->GetVkDevice(), stagingBufferMemory, nullptr);
+}
+
+void BufferUtils::CreateBufferFromBlobs(Device* device, VkCommandPool commandPool, const std::vector<std::pair<const void*, VkDeviceSize>>& blobs, VkBufferUsageFlags bufferUsage, VkBuffer& buffer, VkDeviceMemory& bufferMemory) {
+    VkDeviceSize bufferSize = 0;
+    for (const auto& blob : blobs) {
+        bufferSize += blob.second;
+    }
+
+    // Create the staging buffer
+    VkBuffer stagingBuffer;
+    VkDeviceMemory stagingBufferMemory;
+
+    VkBufferUsageFlags stagingUsage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+    VkMemoryPropertyFlags stagingProperties = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+    BufferUtils::CreateBuffer(device, bufferSize, stagingUsage, stagingProperties, stagingBuffer, stagingBufferMemory);
+
+    // Fill the staging buffer
+    void *data;
+    vkMapMemory(device->GetVkDevice(), stagingBufferMemory, 0, bufferSize, 0, &data);
+    char* dst = static_cast<char*>(data);
+    for (const auto& blob : blobs) {
+        memcpy(dst, blob.first, static_cast<size_t>(blob.second));
+        dst += blob.second;
+    }
+    vkUnmapMemory(device->GetVkDevice(), stagingBufferMemory);
+
+    // Create the device local buffer and copy the blobs into it
+    BufferUtils::CreateBuffer(device, bufferSize, VK_BUFFER_USAGE_TRANSFER_DST_BIT | bufferUsage, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, buffer, bufferMemory);
+    BufferUtils::CopyBuffer(device, commandPool, stagingBuffer, buffer, bufferSize);
+
+    // No need for the staging buffer anymore
+    vkDestroyBuffer(device->GetVkDevice(), stagingBuffer, nullptr);
+    device->RecordFree(stagingBufferMemory);
+    vkFreeMemory(device->GetVkDevice(), stagingBufferMemory, nullptr);
+}
+
+void BufferUtils::ReadBuffer(Device* device, VkCommandPool commandPool, VkBuffer buffer, void* bufferData, VkDeviceSize bufferSize) {
+    VkBuffer stagingBuffer;
+    VkDeviceMemory stagingBufferMemory;
+    VkMemoryPropertyFlags stagingProperties = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+    BufferUtils::CreateBuffer(device, bufferSize, VK_BUFFER_USAGE_TRANSFER_DST_BIT, stagingProperties, stagingBuffer, stagingBufferMemory);
+
+    // CopyBuffer waits for the queue, so the staging buffer is complete once it returns
+    BufferUtils::CopyBuffer(device, commandPool, buffer, stagingBuffer, bufferSize);
+
+    void* data;
+    vkMapMemory(device->GetVkDevice(), stagingBufferMemory, 0, bufferSize, 0, &data);
+    memcpy(bufferData, data, static_cast<size_t>(bufferSize));
+    vkUnmapMemory(device->GetVkDevice(), stagingBufferMemory);
+
+    vkDestroyBuffer(device->GetVkDevice(), stagingBuffer, nullptr);
+    device->RecordFree(stagingBufferMemory);
     vkFreeMemory(device->GetVkDevice(), stagingBufferMemory, nullptr);
 }
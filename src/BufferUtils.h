@@ -1,5 +1,7 @@
 #pragma once
 
+#include <utility>
+#include <vector>
 #include <vulkan/vulkan.h>
 #include "Device.h"
 
@@ -7,4 +9,8 @@ namespace BufferUtils {
     void CreateBuffer(Device* device, VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties, VkBuffer& buffer, VkDeviceMemory& bufferMemory);
     void CopyBuffer(Device* device, VkCommandPool commandPool, VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size);
     void CreateBufferFromData(Device* device, VkCommandPool commandPool, void* bufferData, VkDeviceSize bufferSize, VkBufferUsageFlags bufferUsage, VkBuffer& buffer, VkDeviceMemory& bufferMemory);
+    // Same as CreateBufferFromData with several (data, size) blobs copied back to back
+    void CreateBufferFromBlobs(Device* device, VkCommandPool commandPool, const std::vector<std::pair<const void*, VkDeviceSize>>& blobs, VkBufferUsageFlags bufferUsage, VkBuffer& buffer, VkDeviceMemory& bufferMemory);
+    // Copy a device local buffer back to the host, buffer needs VK_BUFFER_USAGE_TRANSFER_SRC_BIT
+    void ReadBuffer(Device* device, VkCommandPool commandPool, VkBuffer buffer, void* bufferData, VkDeviceSize bufferSize);
 }
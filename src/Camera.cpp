@@ -35,6 +35,14 @@ VkBuffer Camera::GetBuffer() const {
     return buffer;
 }
 
+void Camera::SetAspectRatio(float aspectRatio) {
+    cameraBufferObject.projectionMatrix = glm::perspective(glm::radians(45.0f), aspectRatio, 0.1f, 500.0f);
+    cameraBufferObject.projectionMatrix[1][1] *= -1; // y-coordinate is flipped
+    cameraBufferObject.projectionMatrixInverse = glm::inverse(cameraBufferObject.projectionMatrix);
+
+    memcpy(mappedData, &cameraBufferObject, sizeof(CameraBufferObject));
+}
+
 void Camera::UpdateOrbit(float deltaX, float deltaY, float deltaZ) {
     theta += deltaX;
     phi += deltaY;
@@ -74,5 +82,6 @@ void Camera::UpdatePosition(float deltaX, float deltaY, float deltaZ)
 Camera::~Camera() {
   vkUnmapMemory(device->GetVkDevice(), bufferMemory);
   vkDestroyBuffer(device->GetVkDevice(), buffer, nullptr);
+  device->RecordFree(bufferMemory);
   vkFreeMemory(device->GetVkDevice(), bufferMemory, nullptr);
 }
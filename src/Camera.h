@@ -31,6 +31,9 @@ public:
     ~Camera();
 
     VkBuffer GetBuffer() const;
+
+    // Rebuild the projection for a new swapchain extent
+    void SetAspectRatio(float aspectRatio);
     
     void UpdateOrbit(float deltaX, float deltaY, float deltaZ);
 	void UpdatePosition(float deltaX, float deltaY, float deltaZ);
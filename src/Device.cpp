@@ -1,8 +1,49 @@
+#include <algorithm>
 #include "Device.h"
 #include "Instance.h"
 
-Device::Device(Instance* instance, VkDevice vkDevice, Queues queues)
-  : instance(instance), vkDevice(vkDevice), queues(queues) {
+Device::Device(Instance* instance, VkDevice vkDevice, Queues queues, VkPhysicalDeviceFeatures enabledFeatures)
+  : instance(instance), vkDevice(vkDevice), queues(queues), enabledFeatures(enabledFeatures) {
+}
+
+const VkPhysicalDeviceFeatures& Device::GetEnabledFeatures() const {
+    return enabledFeatures;
+}
+
+void Device::RecordAllocation(VkDeviceMemory memory, VkDeviceSize size) {
+    std::lock_guard<std::mutex> lock(allocationMutex);
+    allocations[memory] = size;
+    residentBytes += size;
+    peakBytes = std::max(peakBytes, residentBytes);
+}
+
+void Device::RecordFree(VkDeviceMemory memory) {
+    std::lock_guard<std::mutex> lock(allocationMutex);
+    auto allocation = allocations.find(memory);
+    if (allocation != allocations.end()) {
+        residentBytes -= allocation->second;
+        allocations.erase(allocation);
+    }
+}
+
+VkDeviceSize Device::GetResidentBytes() const {
+    std::lock_guard<std::mutex> lock(allocationMutex);
+    return residentBytes;
+}
+
+uint32_t Device::GetAllocationCount() const {
+    std::lock_guard<std::mutex> lock(allocationMutex);
+    return static_cast<uint32_t>(allocations.size());
+}
+
+VkDeviceSize Device::GetPeakBytes() const {
+    std::lock_guard<std::mutex> lock(allocationMutex);
+    return peakBytes;
+}
+
+void Device::ResetPeakBytes() {
+    std::lock_guard<std::mutex> lock(allocationMutex);
+    peakBytes = residentBytes;
 }
 
 Instance* Device::GetInstance() {
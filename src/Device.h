@@ -1,7 +1,9 @@
 #pragma once
 
 #include <array>
+#include <mutex>
 #include <stdexcept>
+#include <unordered_map>
 #include <vulkan/vulkan.h>
 #include "QueueFlags.h"
 #include "SwapChain.h"
@@ -16,15 +18,30 @@ public:
     VkDevice GetVkDevice();
     VkQueue GetQueue(QueueFlags flag);
     unsigned int GetQueueIndex(QueueFlags flag);
+    const VkPhysicalDeviceFeatures& GetEnabledFeatures() const;
+
+    // Device memory allocated through BufferUtils and Image, every vkFreeMemory of it goes through RecordFree first
+    void RecordAllocation(VkDeviceMemory memory, VkDeviceSize size);
+    void RecordFree(VkDeviceMemory memory);
+    VkDeviceSize GetResidentBytes() const;
+    uint32_t GetAllocationCount() const;
+    // Highest resident bytes since the last ResetPeakBytes
+    VkDeviceSize GetPeakBytes() const;
+    void ResetPeakBytes();
     ~Device();
 
 private:
     using Queues = std::array<VkQueue, sizeof(QueueFlags)>;
     
     Device() = delete;
-    Device(Instance* instance, VkDevice vkDevice, Queues queues);
+    Device(Instance* instance, VkDevice vkDevice, Queues queues, VkPhysicalDeviceFeatures enabledFeatures);
 
     Instance* instance;
     VkDevice vkDevice;
     Queues queues;
+    VkPhysicalDeviceFeatures enabledFeatures;
+    mutable std::mutex allocationMutex;
+    std::unordered_map<VkDeviceMemory, VkDeviceSize> allocations;
+    VkDeviceSize residentBytes = 0;
+    VkDeviceSize peakBytes = 0;
 };
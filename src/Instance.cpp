@@ -49,7 +49,15 @@ Instance::Instance(const char* applicationName, unsigned int additionalExtension
     appInfo.applicationVersion = VK_MAKE_VERSION(1, 0, 0);
     appInfo.pEngineName = "No Engine";
     appInfo.engineVersion = VK_MAKE_VERSION(1, 0, 0);
-    appInfo.apiVersion = VK_API_VERSION_1_0;
+#ifdef VK_VERSION_1_1
+    // Use 1.1 when the loader has it, the subgroup properties need it
+    auto enumerateInstanceVersion = (PFN_vkEnumerateInstanceVersion)vkGetInstanceProcAddr(VK_NULL_HANDLE, "vkEnumerateInstanceVersion");
+    uint32_t loaderVersion = VK_API_VERSION_1_0;
+    if (enumerateInstanceVersion != nullptr && enumerateInstanceVersion(&loaderVersion) == VK_SUCCESS && loaderVersion >= VK_API_VERSION_1_1) {
+        apiVersion = VK_API_VERSION_1_1;
+    }
+#endif
+    appInfo.apiVersion = apiVersion;
     
     // --- Create Vulkan instance ---
     VkInstanceCreateInfo createInfo = {};
@@ -149,6 +157,33 @@ VkSampleCountFlagBits Instance::GetMaxUsableSampleCount() const
     return VK_SAMPLE_COUNT_1_BIT;
 }
 
+uint32_t Instance::GetSubgroupSize() const
+{
+    VkPhysicalDeviceProperties physicalDeviceProperties;
+    vkGetPhysicalDeviceProperties(physicalDevice, &physicalDeviceProperties);
+
+#ifdef VK_VERSION_1_1
+    if (apiVersion >= VK_API_VERSION_1_1 && physicalDeviceProperties.apiVersion >= VK_API_VERSION_1_1) {
+        VkPhysicalDeviceSubgroupProperties subgroupProperties = {};
+        subgroupProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SUBGROUP_PROPERTIES;
+
+        VkPhysicalDeviceProperties2 physicalDeviceProperties2 = {};
+        physicalDeviceProperties2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+        physicalDeviceProperties2.pNext = &subgroupProperties;
+        vkGetPhysicalDeviceProperties2(physicalDevice, &physicalDeviceProperties2);
+
+        if (subgroupProperties.subgroupSize > 0) {
+            return subgroupProperties.subgroupSize;
+        }
+    }
+#endif
+
+    // Vulkan 1.0 has no subgroup query, fall back to the vendor's native width:
+    // AMD runs compute as wave64, NVIDIA and most others use 32 wide subgroups
+    const uint32_t vendorAMD = 0x1002;
+    return physicalDeviceProperties.vendorID == vendorAMD ? 64 : 32;
+}
+
 void Instance::initDebugReport() {
     if (ENABLE_VALIDATION) {
         // Specify details for callback
@@ -373,7 +408,7 @@ Device* Instance::CreateDevice(QueueFlagBits requiredQueues, VkPhysicalDeviceFea
         }
     }
 
-    return new Device(this, vkDevice, queues);
+    return new Device(this, vkDevice, queues, deviceFeatures);
 }
 
 Instance::~Instance() {
@@ -24,6 +24,7 @@ public:
     uint32_t GetMemoryTypeIndex(uint32_t types, VkMemoryPropertyFlags properties) const;
     VkFormat GetSupportedFormat(const std::vector<VkFormat>& candidates, VkImageTiling tiling, VkFormatFeatureFlags features) const;
     VkSampleCountFlagBits GetMaxUsableSampleCount() const;
+    uint32_t GetSubgroupSize() const;
 
     void PickPhysicalDevice(std::vector<const char*> deviceExtensions, QueueFlagBits requiredQueues, VkSurfaceKHR surface = VK_NULL_HANDLE);
 
@@ -36,6 +37,7 @@ private:
     void initDebugReport();
 
     VkInstance instance;
+    uint32_t apiVersion = VK_API_VERSION_1_0;
     VkDebugReportCallbackEXT debugReportCallback;
     std::vector<const char*> deviceExtensions;
     VkPhysicalDevice physicalDevice = VK_NULL_HANDLE;
@@ -0,0 +1,154 @@
+#include "MeshCache.h"
+#include "MeshUtils.h"
+
+#include <fstream>
+#include <iostream>
+#include <sys/stat.h>
+
+namespace {
+    struct SourceInfo {
+        uint64_t size;
+        int64_t time;
+    };
+
+    bool GetSourceInfo(const std::string& path, SourceInfo& info) {
+        struct stat status;
+        if (stat(path.c_str(), &status) != 0) {
+            return false;
+        }
+        info.size = static_cast<uint64_t>(status.st_size);
+        info.time = static_cast<int64_t>(status.st_mtime);
+        return true;
+    }
+
+    // FNV-1a over the whole source file
+    bool HashSource(const std::string& path, uint64_t& hash) {
+        MappedFile source;
+        if (!source.Open(path)) {
+            return false;
+        }
+        const unsigned char* bytes = static_cast<const unsigned char*>(source.GetData());
+        hash = 14695981039346656037ull;
+        for (size_t i = 0; i < source.GetSize(); i++) {
+            hash ^= bytes[i];
+            hash *= 1099511628211ull;
+        }
+        return true;
+    }
+}
+
+MeshCache::MeshCache(const std::string& sourceFile) {
+    std::string cacheFile = sourceFile + ".cache";
+    if (file.Open(cacheFile) && Validate(sourceFile)) {
+        return;
+    }
+
+    file.Close();
+    header = nullptr;
+    Rebuild(sourceFile, cacheFile);
+}
+
+bool MeshCache::Validate(const std::string& sourceFile) {
+    if (file.GetSize() < sizeof(MeshCacheHeader)) {
+        return false;
+    }
+
+    const MeshCacheHeader* cached = static_cast<const MeshCacheHeader*>(file.GetData());
+    if (cached->magic != MESH_CACHE_MAGIC || cached->version != MESH_CACHE_VERSION || cached->vertexStride != sizeof(ReedVertex)) {
+        return false;
+    }
+
+    uint64_t vertexEnd = uint64_t(cached->vertexOffset) + uint64_t(cached->vertexCount) * sizeof(ReedVertex);
+    uint64_t indexEnd = uint64_t(cached->indexOffset) + uint64_t(cached->indexCount) * sizeof(uint32_t);
+    if (vertexEnd > file.GetSize() || indexEnd > file.GetSize() || cached->indexOffset % sizeof(uint32_t) != 0) {
+        return false;
+    }
+    for (uint32_t l = 0; l < REED_LOD_COUNT; l++) {
+        const ReedMeshRange& lod = cached->lods[l];
+        if (uint64_t(lod.firstIndex) + lod.indexCount > cached->indexCount || lod.vertexOffset < 0 || uint32_t(lod.vertexOffset) >= cached->vertexCount) {
+            return false;
+        }
+    }
+
+    // Timestamp and size match, skip hashing. A cache without its source is used as is
+    SourceInfo info;
+    if (!GetSourceInfo(sourceFile, info) || (info.size == cached->sourceSize && info.time == cached->sourceTime)) {
+        header = cached;
+        return true;
+    }
+
+    // Touched but maybe unchanged, compare contents
+    uint64_t hash;
+    if (info.size == cached->sourceSize && HashSource(sourceFile, hash) && hash == cached->sourceHash) {
+        header = cached;
+        return true;
+    }
+
+    return false;
+}
+
+void MeshCache::Rebuild(const std::string& sourceFile, const std::string& cacheFile) {
+    MeshUtils::LoadReedMesh(sourceFile, vertices, indices, lods);
+
+    MeshCacheHeader newHeader = {};
+    newHeader.magic = MESH_CACHE_MAGIC;
+    newHeader.version = MESH_CACHE_VERSION;
+    SourceInfo info = {};
+    GetSourceInfo(sourceFile, info);
+    newHeader.sourceSize = info.size;
+    newHeader.sourceTime = info.time;
+    HashSource(sourceFile, newHeader.sourceHash);
+    newHeader.vertexStride = sizeof(ReedVertex);
+    newHeader.vertexCount = static_cast<uint32_t>(vertices.size());
+    newHeader.vertexOffset = sizeof(MeshCacheHeader);
+    newHeader.indexCount = static_cast<uint32_t>(indices.size());
+    newHeader.indexOffset = newHeader.vertexOffset + newHeader.vertexCount * sizeof(ReedVertex);
+    for (uint32_t l = 0; l < REED_LOD_COUNT; l++) {
+        newHeader.lods[l] = lods[l];
+    }
+
+    {
+        std::ofstream out(cacheFile, std::ios::binary | std::ios::trunc);
+        out.write(reinterpret_cast<const char*>(&newHeader), sizeof(newHeader));
+        out.write(reinterpret_cast<const char*>(vertices.data()), vertices.size() * sizeof(ReedVertex));
+        out.write(reinterpret_cast<const char*>(indices.data()), indices.size() * sizeof(uint32_t));
+        if (!out) {
+            std::cout << "Failed to write mesh cache " << cacheFile << std::endl;
+            return;
+        }
+    }
+
+    // Serve from the mapping like a warm start so both paths behave the same
+    if (file.Open(cacheFile) && Validate(sourceFile)) {
+        vertices.clear();
+        vertices.shrink_to_fit();
+        indices.clear();
+        indices.shrink_to_fit();
+    }
+    else {
+        file.Close();
+        header = nullptr;
+    }
+}
+
+const ReedVertex* MeshCache::GetVertices() const {
+    if (header == nullptr) return vertices.data();
+    return reinterpret_cast<const ReedVertex*>(static_cast<const char*>(file.GetData()) + header->vertexOffset);
+}
+
+uint32_t MeshCache::GetVertexCount() const {
+    return header == nullptr ? static_cast<uint32_t>(vertices.size()) : header->vertexCount;
+}
+
+const uint32_t* MeshCache::GetIndices() const {
+    if (header == nullptr) return indices.data();
+    return reinterpret_cast<const uint32_t*>(static_cast<const char*>(file.GetData()) + header->indexOffset);
+}
+
+uint32_t MeshCache::GetIndexCount() const {
+    return header == nullptr ? static_cast<uint32_t>(indices.size()) : header->indexCount;
+}
+
+ReedMeshRange MeshCache::GetLod(uint32_t lod) const {
+    return header == nullptr ? lods[lod] : header->lods[lod];
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "MappedFile.h"
+#include "Reeds.h"
+
+// "RMSH", bump the version whenever ReedVertex or the import changes
+constexpr static uint32_t MESH_CACHE_MAGIC = 0x48534d52;
+constexpr static uint32_t MESH_CACHE_VERSION = 2;
+
+struct MeshCacheHeader {
+    uint32_t magic;
+    uint32_t version;
+    // Source OBJ the cache was built from
+    uint64_t sourceSize;
+    int64_t sourceTime;
+    uint64_t sourceHash;
+    // Blobs follow the header, offsets are in bytes from the start of the file
+    uint32_t vertexStride;
+    uint32_t vertexCount;
+    uint32_t vertexOffset;
+    uint32_t indexCount;
+    uint32_t indexOffset;
+    // Ranges of each LOD within the blobs
+    ReedMeshRange lods[REED_LOD_COUNT];
+    uint32_t padding;
+};
+
+static_assert(sizeof(MeshCacheHeader) == 56 + sizeof(ReedMeshRange) * REED_LOD_COUNT, "MeshCacheHeader is written to disk as is");
+
+// Binary reed mesh stored next to the OBJ, built on first load and mapped afterwards
+class MeshCache {
+private:
+    MappedFile file;
+    const MeshCacheHeader* header = nullptr;
+
+    // Used when the cache could not be written
+    std::vector<ReedVertex> vertices;
+    std::vector<uint32_t> indices;
+    ReedMeshRange lods[REED_LOD_COUNT];
+
+    bool Validate(const std::string& sourceFile);
+    void Rebuild(const std::string& sourceFile, const std::string& cacheFile);
+
+public:
+    explicit MeshCache(const std::string& sourceFile);
+
+    const ReedVertex* GetVertices() const;
+    uint32_t GetVertexCount() const;
+    const uint32_t* GetIndices() const;
+    uint32_t GetIndexCount() const;
+    ReedMeshRange GetLod(uint32_t lod) const;
+};
@@ -1,86 +1,70 @@
 #include "Reeds.h"
+#include <algorithm>
 #include <vector>
 #include "BufferUtils.h"
-#include "glm/gtc/noise.hpp"
+#include "MeshCache.h"
+#include "SceneSnapshot.h"
 
 VkBuffer Reed::reedVertexBuffer = 0;
 VkBuffer Reed::reedIndexBuffer = 0;
 VkDeviceMemory Reed::reedVertexBufferMemory = 0;
 VkDeviceMemory Reed::reedIndexBufferMemory = 0;
-uint32_t Reed::reedIndexCount = 0;
+ReedMeshRange Reed::meshRanges[REED_VARIANT_COUNT][REED_LOD_COUNT] = {};
 
-#define UNIFORM_SPAWN 0
-
-Reeds::Reeds(Device* device, VkCommandPool commandPool, float planeDim, glm::vec3 offset) : Model(device, commandPool, {}, {})
+Reeds::Reeds(Device* device, VkCommandPool commandPool, float planeDim, const std::vector<glm::vec3>& tileOffsets, const ReedSettings& settings, const SceneSnapshot* snapshot) : Model(device, commandPool, {}, {}),
+    tileCount(static_cast<uint32_t>(tileOffsets.size())), reedsPerTile(settings.ReedsPerTile())
 {
-    std::vector<Reed> reeds;
-    reeds.resize(NUM_REED * NUM_REED);
-	float gridSize = planeDim / NUM_REED;
-
-    for (int i = 0; i < NUM_REED; i++) {
-        for (int j = 0; j < NUM_REED; j++) {
-			glm::vec2 gridBase = -0.5f * glm::vec2(planeDim) + glm::vec2(i * gridSize, j * gridSize);
-#if UNIFORM_SPAWN
-            float spawnChance = 0.5f;
-#else
-            float spawnChance = (1.f - glm::perlin(0.02f * gridBase + 146.1413f) * 2.4f) * 0.5f;
-#endif
-            float r = static_cast <float> (rand()) / static_cast <float> (RAND_MAX);
-			if (r > spawnChance) {
-				continue;
-			}
-            
-            Reed currentBlade = Reed();
-
-            glm::vec3 bladeUp = glm::normalize(glm::vec3(0.f, 1.0f, 0.f));
-
-            // Generate positions and direction (v0)
-            float x = generateRandomFloat() * gridSize + gridBase.x;
-            float z = generateRandomFloat() * gridSize + gridBase.y;
-            float y = 0.f;
-            float direction = generateRandomFloat() * 0.2f * 3.14159265f + 1.3f * 3.14159265f;
-            glm::vec3 bladePosition(x, y, z);
-            bladePosition += offset;
-            glm::vec2 bladeXZPosition(bladePosition.x, bladePosition.z);
-            bladePosition.y = terrainHeight(bladeXZPosition);
-
-            currentBlade.v0 = glm::vec4(bladePosition, direction);
-
-            // Bezier point and height (v1)
-            float height = REED_MIN_HEIGHT + (generateRandomFloat() * (REED_MAX_HEIGHT - REED_MIN_HEIGHT));
-            currentBlade.v1 = glm::vec4(bladePosition + bladeUp * height, height);
-
-            // Physical model guide and width (v2)
-            float width = REED_MIN_WIDTH + (generateRandomFloat() * (REED_MAX_WIDTH - REED_MIN_WIDTH));
-            currentBlade.v2 = glm::vec4(bladePosition + bladeUp * height, width);
-
-            // Up vector and stiffness coefficient (up)
-            float stiffness = REED_MIN_BEND + (generateRandomFloat() * (REED_MAX_BEND - REED_MIN_BEND));
-            currentBlade.up = glm::vec4(bladeUp, stiffness);
-
-            reeds[reedsCount++] = currentBlade;
+    const uint32_t reedSlots = tileCount * reedsPerTile;
+    // Transfer source so a snapshot can read them back
+    const VkBufferUsageFlags reedUsage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+
+    if (snapshot != nullptr && snapshot->GetReedCount() == reedSlots) {
+        // Staged straight from the mapping, nothing to generate
+        reedsCount = snapshot->GetReedsSpawned();
+        BufferUtils::CreateBufferFromBlobs(device, commandPool, { std::make_pair(static_cast<const void*>(snapshot->GetReedStatic()), VkDeviceSize(reedSlots) * sizeof(BladeStatic)) }, reedUsage, reedsStaticBuffer, reedsStaticBufferMemory);
+        BufferUtils::CreateBufferFromBlobs(device, commandPool, { std::make_pair(static_cast<const void*>(snapshot->GetReedDynamic()), VkDeviceSize(reedSlots) * sizeof(BladeDynamic)) }, reedUsage, reedsDynamicBuffer, reedsDynamicBufferMemory);
+    }
+    else {
+        // Unused slots stay zero, the simulation skips blades with no height
+        std::vector<BladeStatic> reedsStatic(reedSlots);
+        std::vector<BladeDynamic> reedsDynamic(reedSlots);
+        for (uint32_t t = 0; t < tileCount; ++t) {
+            reedsCount += BladeGeneration::GenerateReedTile(tileOffsets[t], planeDim, settings, &reedsStatic[t * reedsPerTile], &reedsDynamic[t * reedsPerTile]);
+        }
+
+        BufferUtils::CreateBufferFromData(device, commandPool, reedsStatic.data(), reedsStatic.size() * sizeof(BladeStatic), reedUsage, reedsStaticBuffer, reedsStaticBufferMemory);
+        BufferUtils::CreateBufferFromData(device, commandPool, reedsDynamic.data(), reedsDynamic.size() * sizeof(BladeDynamic), reedUsage, reedsDynamicBuffer, reedsDynamicBufferMemory);
+    }
+
+    // One command per tile, variant and LOD, each appending to its own range of the culled list
+    std::vector<ReedsDrawIndirect> indirectDraws(tileCount * REED_DRAW_COUNT);
+    for (uint32_t t = 0; t < tileCount; ++t) {
+        for (uint32_t v = 0; v < REED_VARIANT_COUNT; ++v) {
+            for (uint32_t l = 0; l < REED_LOD_COUNT; ++l) {
+                uint32_t d = t * REED_DRAW_COUNT + v * REED_LOD_COUNT + l;
+                indirectDraws[d].indexCount = Reed::meshRanges[v][l].indexCount;
+                indirectDraws[d].instanceCount = 0;
+                indirectDraws[d].firstIndex = Reed::meshRanges[v][l].firstIndex;
+                indirectDraws[d].vertexOffset = Reed::meshRanges[v][l].vertexOffset;
+                indirectDraws[d].firstInstance = d * GetDrawCapacity();
+            }
         }
     }
 
-    ReedsDrawIndirect indirectDraw;
-    /*indirectDraw.vertexCount = NUM_BLADES;
-    indirectDraw.instanceCount = 1;
-    indirectDraw.firstVertex = 0;
-    indirectDraw.firstInstance = 0;*/
-    indirectDraw.indexCount = Reed::reedIndexCount;
-    indirectDraw.instanceCount = 0;
-    indirectDraw.firstIndex = 0;
-    indirectDraw.vertexOffset = 0;
-    indirectDraw.firstInstance = 0;
-
-    BufferUtils::CreateBufferFromData(device, commandPool, reeds.data(), reeds.size() * sizeof(Reed), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, reedsBuffer, reedsBufferrMemory);
-    BufferUtils::CreateBuffer(device, reeds.size() * sizeof(Reed), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT, culledReedsBuffer, culledReedsBufferMemory);
-    BufferUtils::CreateBufferFromData(device, commandPool, &indirectDraw, sizeof(ReedsDrawIndirect), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT, numReedsBuffer, numReedsBufferMemory);
+    // Culling writes the 16-bit indices of the visible reeds, only the GPU touches them
+    BufferUtils::CreateBuffer(device, BladePacking::CulledIndexListSize(tileCount * REED_DRAW_COUNT * GetDrawCapacity()), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, culledReedsBuffer, culledReedsBufferMemory);
+    BufferUtils::CreateBufferFromData(device, commandPool, indirectDraws.data(), indirectDraws.size() * sizeof(ReedsDrawIndirect), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, numReedsBuffer, numReedsBufferMemory);
+    BufferUtils::CreateBufferFromData(device, commandPool, indirectDraws.data(), indirectDraws.size() * sizeof(ReedsDrawIndirect), VK_BUFFER_USAGE_TRANSFER_SRC_BIT, numReedsResetBuffer, numReedsResetBufferMemory);
 }
 
-VkBuffer Reeds::GetReedsBuffer() const
+VkBuffer Reeds::GetReedsStaticBuffer() const
 {
-	return reedsBuffer;
+	return reedsStaticBuffer;
+}
+
+VkBuffer Reeds::GetReedsDynamicBuffer() const
+{
+	return reedsDynamicBuffer;
 }
 
 VkBuffer Reeds::GetCulledReedsBuffer() const
@@ -93,29 +77,80 @@ VkBuffer Reeds::GetNumReedsBuffer() const
 	return numReedsBuffer;
 }
 
+VkBuffer Reeds::GetNumReedsResetBuffer() const
+{
+	return numReedsResetBuffer;
+}
+
+uint32_t Reeds::GetTileCount() const
+{
+	return tileCount;
+}
+
+uint32_t Reeds::GetReedsPerTile() const
+{
+	return reedsPerTile;
+}
+
+uint32_t Reeds::GetDrawCapacity() const
+{
+	return reedsPerTile;
+}
+
 Reeds::~Reeds()
 {
-	vkDestroyBuffer(device->GetVkDevice(), reedsBuffer, nullptr);
-	vkFreeMemory(device->GetVkDevice(), reedsBufferrMemory, nullptr);
+	vkDestroyBuffer(device->GetVkDevice(), reedsStaticBuffer, nullptr);
+	device->RecordFree(reedsStaticBufferMemory);
+	vkFreeMemory(device->GetVkDevice(), reedsStaticBufferMemory, nullptr);
+	vkDestroyBuffer(device->GetVkDevice(), reedsDynamicBuffer, nullptr);
+	device->RecordFree(reedsDynamicBufferMemory);
+	vkFreeMemory(device->GetVkDevice(), reedsDynamicBufferMemory, nullptr);
 	vkDestroyBuffer(device->GetVkDevice(), culledReedsBuffer, nullptr);
+	device->RecordFree(culledReedsBufferMemory);
 	vkFreeMemory(device->GetVkDevice(), culledReedsBufferMemory, nullptr);
 	vkDestroyBuffer(device->GetVkDevice(), numReedsBuffer, nullptr);
+	device->RecordFree(numReedsBufferMemory);
 	vkFreeMemory(device->GetVkDevice(), numReedsBufferMemory, nullptr);
+	vkDestroyBuffer(device->GetVkDevice(), numReedsResetBuffer, nullptr);
+	device->RecordFree(numReedsResetBufferMemory);
+	vkFreeMemory(device->GetVkDevice(), numReedsResetBufferMemory, nullptr);
 }
 
-void Reed::CreateBladeVertexIndexBuffer(Device* device, VkCommandPool commandPool, std::vector<ReedVertex> vertexBuffer, std::vector<uint32_t> indexBuffer)
+void Reed::CreateBladeVertexIndexBuffer(Device* device, VkCommandPool commandPool, const std::vector<const MeshCache*>& meshes)
 {
-	BufferUtils::CreateBufferFromData(device, commandPool, vertexBuffer.data(),
-		vertexBuffer.size() * sizeof(ReedVertex), VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, Reed::reedVertexBuffer, Reed::reedVertexBufferMemory);
-	BufferUtils::CreateBufferFromData(device, commandPool, indexBuffer.data(),
-		indexBuffer.size() * sizeof(uint32_t), VK_BUFFER_USAGE_INDEX_BUFFER_BIT, Reed::reedIndexBuffer, Reed::reedIndexBufferMemory);
-	reedIndexCount = indexBuffer.size();
+	if (meshes.size() != REED_VARIANT_COUNT) {
+		throw std::runtime_error("Expected one mesh per reed variant");
+	}
+
+	// Staged straight from each mesh cache mapping, variants are laid out back to back
+	std::vector<std::pair<const void*, VkDeviceSize>> vertexBlobs;
+	std::vector<std::pair<const void*, VkDeviceSize>> indexBlobs;
+	uint32_t vertexCount = 0;
+	uint32_t indexCount = 0;
+	for (uint32_t v = 0; v < REED_VARIANT_COUNT; ++v) {
+		const MeshCache* mesh = meshes[v];
+		for (uint32_t l = 0; l < REED_LOD_COUNT; ++l) {
+			ReedMeshRange lod = mesh->GetLod(l);
+			meshRanges[v][l].firstIndex = indexCount + lod.firstIndex;
+			meshRanges[v][l].indexCount = lod.indexCount;
+			meshRanges[v][l].vertexOffset = static_cast<int32_t>(vertexCount) + lod.vertexOffset;
+		}
+		vertexBlobs.push_back(std::make_pair(static_cast<const void*>(mesh->GetVertices()), VkDeviceSize(mesh->GetVertexCount()) * sizeof(ReedVertex)));
+		indexBlobs.push_back(std::make_pair(static_cast<const void*>(mesh->GetIndices()), VkDeviceSize(mesh->GetIndexCount()) * sizeof(uint32_t)));
+		vertexCount += mesh->GetVertexCount();
+		indexCount += mesh->GetIndexCount();
+	}
+
+	BufferUtils::CreateBufferFromBlobs(device, commandPool, vertexBlobs, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, Reed::reedVertexBuffer, Reed::reedVertexBufferMemory);
+	BufferUtils::CreateBufferFromBlobs(device, commandPool, indexBlobs, VK_BUFFER_USAGE_INDEX_BUFFER_BIT, Reed::reedIndexBuffer, Reed::reedIndexBufferMemory);
 }
 
 void Reed::DestroyBladeVertexIndexBuffer(Device* device)
 {
 	vkDestroyBuffer(device->GetVkDevice(), reedVertexBuffer, nullptr);
+	device->RecordFree(reedVertexBufferMemory);
 	vkFreeMemory(device->GetVkDevice(), reedVertexBufferMemory, nullptr);
 	vkDestroyBuffer(device->GetVkDevice(), reedIndexBuffer, nullptr);
+	device->RecordFree(reedIndexBufferMemory);
 	vkFreeMemory(device->GetVkDevice(), reedIndexBufferMemory, nullptr);
 }
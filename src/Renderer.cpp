@@ -6,10 +6,47 @@
 #include "Camera.h"
 #include "Image.h"
 #include "BufferUtils.h"
-
-static constexpr unsigned int WORKGROUP_SIZE = 32;
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <future>
+#include <iostream>
+#include <limits>
+#include <thread>
+
+// Force the compute workgroup size (e.g. to compare sizes), 0 picks it from the device subgroup size
+#define COMPUTE_WORKGROUP_SIZE 0
 #define RENDER_REEDS 1
 #define RENDER_GRASS 1
+// Relative to the working directory like shaders/ and images/, rejected when the device or driver changes
+#define PIPELINE_CACHE_FILE "pipeline_cache.bin"
+// Frames the CPU may record ahead of the GPU, each with its own command pools and fence
+#define MAX_FRAMES_IN_FLIGHT 2
+// Upper bound on threads recording secondary command buffers for the scene pass
+#define MAX_RECORDING_THREADS 4
+// Wind field resolution, same as the noise texture it is built from, and its grass, reed and leaf layers
+#define WIND_FIELD_SIZE 256
+#define WIND_FIELD_LAYERS 3
+// Keep in sync with wind.comp
+#define WIND_FIELD_WORKGROUP_SIZE 8
+// Collider grid cells and the slots of each, keep in sync with shaders/collider.glsl
+#define COLLIDER_GRID_CELLS (128 * 128)
+#define MAX_COLLIDERS_PER_CELL 16
+// Keep in sync with colliders.comp
+#define COLLIDER_WORKGROUP_SIZE 64
+
+namespace {
+    // Timestamps written by each frame, offsets into its range of the query pool
+    enum TimestampQuery {
+        TIMESTAMP_COMPUTE_BEGIN,
+        TIMESTAMP_COMPUTE_END,
+        TIMESTAMP_SCENE_BEGIN,
+        TIMESTAMP_SCENE_END,
+        TIMESTAMP_POST_PROCESS_END,
+        TIMESTAMPS_PER_FRAME,
+    };
+}
 
 Renderer::Renderer(Device* device, SwapChain* swapChain, Scene* scene, Camera* camera)
   : device(device),
@@ -18,6 +55,7 @@ Renderer::Renderer(Device* device, SwapChain* swapChain, Scene* scene, Camera* c
     scene(scene),
     camera(camera) {
 
+    ChooseWorkgroupSize();
     CreateCommandPools();
     CreateRenderPass();
     CreatePostProcessRenderPass();
@@ -28,8 +66,12 @@ Renderer::Renderer(Device* device, SwapChain* swapChain, Scene* scene, Camera* c
     CreateComputeDescriptorSetLayout();
 	CreateColorDepthDescriptorSetLayout();
 	CreateNoiseMapDescriptorSetLayout();
+    CreateWindFieldDescriptorSetLayout();
 
     CreateDescriptorPool();
+    CreateSimulationStatsBuffer();
+    CreateWindField();
+    CreateColliderGrid();
 
     CreateCameraDescriptorSet();
     CreateModelDescriptorSets();
@@ -38,19 +80,173 @@ Renderer::Renderer(Device* device, SwapChain* swapChain, Scene* scene, Camera* c
     CreateComputeDescriptorSets();
 	CreateReedsComputeDescriptorSets();
 	CreateNoiseMapDescriptorSet();
+    CreateWindFieldDescriptorSet();
 
     CreateFrameResources();
     CreateColorDepthDescriptorSet();
 
-    CreateGraphicsPipeline();
-    CreateGrassPipeline();
-    CreateComputePipeline();
-    CreateGrassInstancedPipeline();
-    CreateReedInstancedPipeline();
-    CreatePostProcessPipeline();
-    //RecordCommandBuffers();
-	RecordGrassCommandBuffer();
-    RecordComputeCommandBuffer();
+    CreatePipelineCache();
+    auto pipelineStart = std::chrono::high_resolution_clock::now();
+    CreatePipelinesParallel({
+        &Renderer::CreateGraphicsPipeline,
+        &Renderer::CreateGrassPipeline,
+        &Renderer::CreateComputePipeline,
+        &Renderer::CreateGeneratePipeline,
+        &Renderer::CreateWindPipeline,
+        &Renderer::CreateColliderPipeline,
+        &Renderer::CreateGrassInstancedPipeline,
+        &Renderer::CreateReedInstancedPipeline,
+        &Renderer::CreatePostProcessPipeline,
+    });
+    std::chrono::duration<double, std::milli> pipelineTime = std::chrono::high_resolution_clock::now() - pipelineStart;
+    std::cout << "Created pipelines in " << pipelineTime.count() << " ms" << std::endl;
+    SavePipelineCache();
+    GenerateBlades();
+    CreateFrameContexts();
+    CreateTimestampQueryPool();
+    RecordComputeCommandBuffers();
+}
+
+void Renderer::ChooseWorkgroupSize() {
+#if COMPUTE_WORKGROUP_SIZE
+    workgroupSize = COMPUTE_WORKGROUP_SIZE;
+#else
+    // At least one full subgroup per workgroup: 64 on AMD wave64, 32 on NVIDIA
+    workgroupSize = std::max(device->GetInstance()->GetSubgroupSize(), 32u);
+#endif
+
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(device->GetInstance()->GetPhysicalDevice(), &properties);
+    workgroupSize = std::min(workgroupSize, std::min(properties.limits.maxComputeWorkGroupSize[0], properties.limits.maxComputeWorkGroupInvocations));
+}
+
+namespace {
+    // Prefix of PIPELINE_CACHE_FILE, the driver's blob only records vendor, device and UUID
+    struct PipelineCacheFileHeader {
+        uint32_t magic;
+        uint32_t dataSize;
+        uint32_t vendorID;
+        uint32_t deviceID;
+        uint32_t driverVersion;
+        uint8_t pipelineCacheUUID[VK_UUID_SIZE];
+    };
+
+    constexpr uint32_t PIPELINE_CACHE_MAGIC = 0x43504756; // "VGPC"
+}
+
+void Renderer::CreatePipelineCache() {
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(device->GetInstance()->GetPhysicalDevice(), &properties);
+
+    // Only reuse a cache written by this exact device and driver
+    std::vector<char> initialData;
+    std::ifstream file(PIPELINE_CACHE_FILE, std::ios::binary | std::ios::ate);
+    const std::streamoff fileSize = file ? static_cast<std::streamoff>(file.tellg()) : 0;
+    file.seekg(0);
+    PipelineCacheFileHeader header = {};
+    // A truncated or corrupt file must not size the read past what it holds
+    if (file.read(reinterpret_cast<char*>(&header), sizeof(header)) &&
+        header.magic == PIPELINE_CACHE_MAGIC &&
+        header.dataSize <= fileSize - static_cast<std::streamoff>(sizeof(header)) &&
+        header.vendorID == properties.vendorID &&
+        header.deviceID == properties.deviceID &&
+        header.driverVersion == properties.driverVersion &&
+        memcmp(header.pipelineCacheUUID, properties.pipelineCacheUUID, VK_UUID_SIZE) == 0) {
+        initialData.resize(header.dataSize);
+        if (!file.read(initialData.data(), initialData.size())) {
+            initialData.clear();
+        }
+    }
+    std::cout << (initialData.empty() ? "Pipeline cache: cold start" : "Pipeline cache: warm start") << std::endl;
+
+    VkPipelineCacheCreateInfo cacheInfo = {};
+    cacheInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+    cacheInfo.initialDataSize = initialData.size();
+    cacheInfo.pInitialData = initialData.empty() ? nullptr : initialData.data();
+
+    if (vkCreatePipelineCache(logicalDevice, &cacheInfo, nullptr, &pipelineCache) != VK_SUCCESS) {
+        throw std::runtime_error("Failed to create pipeline cache");
+    }
+}
+
+void Renderer::SavePipelineCache() {
+    size_t dataSize = 0;
+    if (vkGetPipelineCacheData(logicalDevice, pipelineCache, &dataSize, nullptr) != VK_SUCCESS || dataSize == 0) {
+        return;
+    }
+    std::vector<char> data(dataSize);
+    if (vkGetPipelineCacheData(logicalDevice, pipelineCache, &dataSize, data.data()) != VK_SUCCESS) {
+        return;
+    }
+
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(device->GetInstance()->GetPhysicalDevice(), &properties);
+
+    PipelineCacheFileHeader header = {};
+    header.magic = PIPELINE_CACHE_MAGIC;
+    header.dataSize = static_cast<uint32_t>(dataSize);
+    header.vendorID = properties.vendorID;
+    header.deviceID = properties.deviceID;
+    header.driverVersion = properties.driverVersion;
+    memcpy(header.pipelineCacheUUID, properties.pipelineCacheUUID, VK_UUID_SIZE);
+
+    std::ofstream file(PIPELINE_CACHE_FILE, std::ios::binary | std::ios::trunc);
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(data.data(), dataSize);
+}
+
+void Renderer::CreateTimestampQueryPool() {
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(device->GetInstance()->GetPhysicalDevice(), &properties);
+
+    uint32_t queueFamilyCount = 0;
+    vkGetPhysicalDeviceQueueFamilyProperties(device->GetInstance()->GetPhysicalDevice(), &queueFamilyCount, nullptr);
+    std::vector<VkQueueFamilyProperties> queueFamilies(queueFamilyCount);
+    vkGetPhysicalDeviceQueueFamilyProperties(device->GetInstance()->GetPhysicalDevice(), &queueFamilyCount, queueFamilies.data());
+
+    // Timing is optional, frames are rendered the same without it
+    const QueueFamilyIndices& queueFamilyIndices = device->GetInstance()->GetQueueFamilyIndices();
+    if (properties.limits.timestampPeriod == 0.f ||
+        queueFamilies[queueFamilyIndices[QueueFlags::Graphics]].timestampValidBits == 0 ||
+        queueFamilies[queueFamilyIndices[QueueFlags::Compute]].timestampValidBits == 0) {
+        std::cout << "Timestamp queries are not supported, GPU pass times are unavailable" << std::endl;
+        return;
+    }
+    timestampPeriod = properties.limits.timestampPeriod;
+
+    VkQueryPoolCreateInfo queryPoolInfo = {};
+    queryPoolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+    queryPoolInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+    queryPoolInfo.queryCount = static_cast<uint32_t>(frames.size()) * TIMESTAMPS_PER_FRAME;
+
+    if (vkCreateQueryPool(logicalDevice, &queryPoolInfo, nullptr, &timestampQueryPool) != VK_SUCCESS) {
+        throw std::runtime_error("Failed to create timestamp query pool");
+    }
+}
+
+void Renderer::CreateSimulationStatsBuffer() {
+    VkDeviceSize size = MAX_FRAMES_IN_FLIGHT * sizeof(uint32_t);
+    BufferUtils::CreateBuffer(device, size, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, simulationStatsBuffer, simulationStatsBufferMemory);
+
+    void* data;
+    vkMapMemory(logicalDevice, simulationStatsBufferMemory, 0, size, 0, &data);
+    memset(data, 0, static_cast<size_t>(size));
+    mappedSimulationStats = static_cast<const uint32_t*>(data);
+}
+
+void Renderer::CreateWindField() {
+    Image::Create(device, WIND_FIELD_SIZE, WIND_FIELD_SIZE, VK_FORMAT_R16G16B16A16_SFLOAT, VK_IMAGE_TILING_OPTIMAL,
+        VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+        windFieldImage, windFieldImageMemory, VK_SAMPLE_COUNT_1_BIT, WIND_FIELD_LAYERS);
+    windFieldImageView = Image::CreateView(device, windFieldImage, VK_FORMAT_R16G16B16A16_SFLOAT, VK_IMAGE_ASPECT_COLOR_BIT, VK_IMAGE_VIEW_TYPE_2D_ARRAY, WIND_FIELD_LAYERS);
+
+    // Written and sampled in the same layout, so it is transitioned once
+    Image::TransitionLayout(device, graphicsCommandPool, windFieldImage, VK_FORMAT_R16G16B16A16_SFLOAT, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_GENERAL);
+}
+
+void Renderer::CreateColliderGrid() {
+    BufferUtils::CreateBuffer(device, COLLIDER_GRID_CELLS * sizeof(uint32_t), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, colliderCellCountBuffer, colliderCellCountBufferMemory);
+    BufferUtils::CreateBuffer(device, COLLIDER_GRID_CELLS * MAX_COLLIDERS_PER_CELL * sizeof(uint32_t), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, colliderCellBuffer, colliderCellBufferMemory);
 }
 
 void Renderer::CreateCommandPools() {
@@ -272,7 +468,27 @@ void Renderer::CreateTimeDescriptorSetLayout() {
     uboLayoutBinding.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT | VK_SHADER_STAGE_FRAGMENT_BIT | VK_SHADER_STAGE_VERTEX_BIT;
     uboLayoutBinding.pImmutableSamplers = nullptr;
 
-    std::vector<VkDescriptorSetLayoutBinding> bindings = { uboLayoutBinding };
+    // Theme lives next to time so it can change without re-recording
+    VkDescriptorSetLayoutBinding themeLayoutBinding = uboLayoutBinding;
+    themeLayoutBinding.binding = 1;
+    themeLayoutBinding.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
+
+    // Counters written by the simulation
+    VkDescriptorSetLayoutBinding statsLayoutBinding = uboLayoutBinding;
+    statsLayoutBinding.binding = 2;
+    statsLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    statsLayoutBinding.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+
+    // Scene colliders and the grid the binning pass sorts them into
+    VkDescriptorSetLayoutBinding collidersLayoutBinding = statsLayoutBinding;
+    collidersLayoutBinding.binding = 3;
+    VkDescriptorSetLayoutBinding cellCountsLayoutBinding = statsLayoutBinding;
+    cellCountsLayoutBinding.binding = 4;
+    VkDescriptorSetLayoutBinding cellsLayoutBinding = statsLayoutBinding;
+    cellsLayoutBinding.binding = 5;
+
+    std::vector<VkDescriptorSetLayoutBinding> bindings = { uboLayoutBinding, themeLayoutBinding, statsLayoutBinding,
+        collidersLayoutBinding, cellCountsLayoutBinding, cellsLayoutBinding };
 
     // Create the descriptor set layout
     VkDescriptorSetLayoutCreateInfo layoutInfo = {};
@@ -286,15 +502,18 @@ void Renderer::CreateTimeDescriptorSetLayout() {
 }
 
 void Renderer::CreateComputeDescriptorSetLayout() {
-    // create blades buffer dsl
-	VkDescriptorSetLayoutBinding bladesBufferLayoutBinding = {};
-	bladesBufferLayoutBinding.binding = 0;
-	bladesBufferLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
-	bladesBufferLayoutBinding.descriptorCount = 1;
-	bladesBufferLayoutBinding.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
-	bladesBufferLayoutBinding.pImmutableSamplers = nullptr;
+    // create blades buffer dsl, binding 0 holds the static attributes and binding 1 the simulated state
+	VkDescriptorSetLayoutBinding bladesStaticLayoutBinding = {};
+	bladesStaticLayoutBinding.binding = 0;
+	bladesStaticLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+	bladesStaticLayoutBinding.descriptorCount = 1;
+	bladesStaticLayoutBinding.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT | VK_SHADER_STAGE_VERTEX_BIT;
+	bladesStaticLayoutBinding.pImmutableSamplers = nullptr;
 
-    std::vector<VkDescriptorSetLayoutBinding> bindings = { bladesBufferLayoutBinding };
+	VkDescriptorSetLayoutBinding bladesDynamicLayoutBinding = bladesStaticLayoutBinding;
+	bladesDynamicLayoutBinding.binding = 1;
+
+    std::vector<VkDescriptorSetLayoutBinding> bindings = { bladesStaticLayoutBinding, bladesDynamicLayoutBinding };
 
 	VkDescriptorSetLayoutCreateInfo bladesBufferLayoutInfo = {};
 	bladesBufferLayoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
@@ -313,7 +532,7 @@ void Renderer::CreateComputeDescriptorSetLayout() {
 	culledBladesBufferLayoutBinding.stageFlags = VK_SHADER_STAGE_ALL;
 	culledBladesBufferLayoutBinding.pImmutableSamplers = nullptr;
 
-	bindings[0] = culledBladesBufferLayoutBinding;
+	bindings = { culledBladesBufferLayoutBinding };
 
 	VkDescriptorSetLayoutCreateInfo culledBladesBufferLayoutInfo = {};
 	culledBladesBufferLayoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
@@ -375,7 +594,12 @@ void Renderer::CreateNoiseMapDescriptorSetLayout()
     samplerLayoutBinding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT | VK_SHADER_STAGE_COMPUTE_BIT | VK_SHADER_STAGE_VERTEX_BIT;
     samplerLayoutBinding.pImmutableSamplers = nullptr;
 
-    std::vector<VkDescriptorSetLayoutBinding> bindings = { samplerLayoutBinding };
+    // Wind field, read by the simulation and reed leaves
+    VkDescriptorSetLayoutBinding windLayoutBinding = samplerLayoutBinding;
+    windLayoutBinding.binding = 1;
+    windLayoutBinding.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT | VK_SHADER_STAGE_VERTEX_BIT;
+
+    std::vector<VkDescriptorSetLayoutBinding> bindings = { samplerLayoutBinding, windLayoutBinding };
 
     // Create the descriptor set layout
     VkDescriptorSetLayoutCreateInfo layoutInfo = {};
@@ -388,42 +612,70 @@ void Renderer::CreateNoiseMapDescriptorSetLayout()
     }
 }
 
+void Renderer::CreateWindFieldDescriptorSetLayout() {
+    VkDescriptorSetLayoutBinding windFieldLayoutBinding = {};
+    windFieldLayoutBinding.binding = 0;
+    windFieldLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+    windFieldLayoutBinding.descriptorCount = 1;
+    windFieldLayoutBinding.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+    windFieldLayoutBinding.pImmutableSamplers = nullptr;
+
+    VkDescriptorSetLayoutCreateInfo layoutInfo = {};
+    layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    layoutInfo.bindingCount = 1;
+    layoutInfo.pBindings = &windFieldLayoutBinding;
+
+    if (vkCreateDescriptorSetLayout(logicalDevice, &layoutInfo, nullptr, &windFieldDescriptorSetLayout) != VK_SUCCESS) {
+        throw std::runtime_error("Failed to create descriptor set layout");
+    }
+}
+
 void Renderer::CreateDescriptorPool() {
+    const uint32_t modelCount = static_cast<uint32_t>(scene->GetModels().size());
+    const uint32_t bladesCount = static_cast<uint32_t>(scene->GetBlades().size());
+    const uint32_t reedsCount = static_cast<uint32_t>(scene->GetReeds().size());
+
     // Describe which descriptor types that the descriptor sets will contain
     std::vector<VkDescriptorPoolSize> poolSizes = {
         // Camera
         { VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER , 1},
 
-        // Models + Blades
-        { VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER , 2 * static_cast<uint32_t>(scene->GetModels().size() + scene->GetBlades().size()) },
-
-        // Models + Blades
-        { VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER , 2 * static_cast<uint32_t>(scene->GetModels().size() + scene->GetBlades().size()) },
+        // Models + Blades, a model uniform buffer and texture each
+        { VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER , modelCount + bladesCount },
+        { VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER , modelCount + bladesCount },
 
-        // Time (compute)
-        { VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER , 1 },
+        // Time + Theme
+        { VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER , 2 },
 
-        // blades buffer
-        {VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 2 * static_cast<uint32_t>(scene->GetBlades().size())},
+        // Simulation stats + colliders and their grid
+        { VK_DESCRIPTOR_TYPE_STORAGE_BUFFER , 4 },
 
-		// culled blades buffer
-		{VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 2 * static_cast<uint32_t>(scene->GetBlades().size())},
+        // blades static + dynamic, culled and num blades buffers
+        {VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 4 * bladesCount},
 
-		// num blades buffer
-		{VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 2 * static_cast<uint32_t>(scene->GetBlades().size())},
+        // reeds static + dynamic, culled and num reeds buffers
+        {VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 4 * reedsCount},
 
 		// color depth buffer
-		{VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 2},
+		{VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1},
+
+        // noise map + wind field
+        { VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER , 2 },
 
-        // noise map
-        { VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER , 1 }
+        // wind field written by the wind pass
+        { VK_DESCRIPTOR_TYPE_STORAGE_IMAGE , 1 }
     };
 
+    // Pool sizes must be positive, a scene without reeds has none of theirs
+    poolSizes.erase(std::remove_if(poolSizes.begin(), poolSizes.end(), [](const VkDescriptorPoolSize& size) { return size.descriptorCount == 0; }), poolSizes.end());
+
     VkDescriptorPoolCreateInfo poolInfo = {};
     poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
     poolInfo.poolSizeCount = static_cast<uint32_t>(poolSizes.size());
     poolInfo.pPoolSizes = poolSizes.data();
-    poolInfo.maxSets = 6 + 14 * scene->GetBlades().size();
+    // Camera, time, color depth, noise map and wind field, one set per model, a graphics set and
+    // three compute sets per Blades, and three compute sets per Reeds
+    poolInfo.maxSets = 5 + modelCount + 4 * bladesCount + 3 * reedsCount;
 
     if (vkCreateDescriptorPool(logicalDevice, &poolInfo, nullptr, &descriptorPool) != VK_SUCCESS) {
         throw std::runtime_error("Failed to create descriptor pool");
@@ -584,7 +836,28 @@ void Renderer::CreateTimeDescriptorSet() {
     timeBufferInfo.offset = 0;
     timeBufferInfo.range = sizeof(Time);
 
-    std::array<VkWriteDescriptorSet, 1> descriptorWrites = {};
+    VkDescriptorBufferInfo themeBufferInfo = {};
+    themeBufferInfo.buffer = scene->GetThemeBuffer();
+    themeBufferInfo.offset = 0;
+    themeBufferInfo.range = sizeof(Theme);
+
+    VkDescriptorBufferInfo statsBufferInfo = {};
+    statsBufferInfo.buffer = simulationStatsBuffer;
+    statsBufferInfo.offset = 0;
+    statsBufferInfo.range = VK_WHOLE_SIZE;
+
+    VkDescriptorBufferInfo collidersBufferInfo = {};
+    collidersBufferInfo.buffer = scene->GetColliderBuffer();
+    collidersBufferInfo.offset = 0;
+    collidersBufferInfo.range = VK_WHOLE_SIZE;
+
+    VkDescriptorBufferInfo cellCountsBufferInfo = collidersBufferInfo;
+    cellCountsBufferInfo.buffer = colliderCellCountBuffer;
+
+    VkDescriptorBufferInfo cellsBufferInfo = collidersBufferInfo;
+    cellsBufferInfo.buffer = colliderCellBuffer;
+
+    std::array<VkWriteDescriptorSet, 6> descriptorWrites = {};
     descriptorWrites[0].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
     descriptorWrites[0].dstSet = timeDescriptorSet;
     descriptorWrites[0].dstBinding = 0;
@@ -595,6 +868,27 @@ void Renderer::CreateTimeDescriptorSet() {
     descriptorWrites[0].pImageInfo = nullptr;
     descriptorWrites[0].pTexelBufferView = nullptr;
 
+    descriptorWrites[1] = descriptorWrites[0];
+    descriptorWrites[1].dstBinding = 1;
+    descriptorWrites[1].pBufferInfo = &themeBufferInfo;
+
+    descriptorWrites[2] = descriptorWrites[0];
+    descriptorWrites[2].dstBinding = 2;
+    descriptorWrites[2].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    descriptorWrites[2].pBufferInfo = &statsBufferInfo;
+
+    descriptorWrites[3] = descriptorWrites[2];
+    descriptorWrites[3].dstBinding = 3;
+    descriptorWrites[3].pBufferInfo = &collidersBufferInfo;
+
+    descriptorWrites[4] = descriptorWrites[2];
+    descriptorWrites[4].dstBinding = 4;
+    descriptorWrites[4].pBufferInfo = &cellCountsBufferInfo;
+
+    descriptorWrites[5] = descriptorWrites[2];
+    descriptorWrites[5].dstBinding = 5;
+    descriptorWrites[5].pBufferInfo = &cellsBufferInfo;
+
     // Update descriptor sets
     vkUpdateDescriptorSets(logicalDevice, static_cast<uint32_t>(descriptorWrites.size()), descriptorWrites.data(), 0, nullptr);
 }
@@ -639,25 +933,29 @@ void Renderer::CreateComputeDescriptorSets() {
 
     for (uint32_t i = 0; i < scene->GetBlades().size(); ++i)
     {
-        VkDescriptorBufferInfo bladesBufferInfo = {};
-        bladesBufferInfo.buffer = scene->GetBlades()[i]->GetBladesBuffer();
-        bladesBufferInfo.offset = 0;
-		bladesBufferInfo.range = sizeof(Blade) * NUM_BLADES;
-
+        VkDescriptorBufferInfo bladesBufferInfos[2] = {};
+        bladesBufferInfos[0].buffer = scene->GetBlades()[i]->GetBladesStaticBuffer();
+        bladesBufferInfos[0].offset = 0;
+        bladesBufferInfos[0].range = VK_WHOLE_SIZE;
+        bladesBufferInfos[1].buffer = scene->GetBlades()[i]->GetBladesDynamicBuffer();
+        bladesBufferInfos[1].offset = 0;
+        bladesBufferInfos[1].range = VK_WHOLE_SIZE;
+
+        // Both bindings are consecutive, so a single write covers them
         bladesBufferDescriptorWrites[i].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
         bladesBufferDescriptorWrites[i].dstSet = bladesBufferDescriptorSets[i];
         bladesBufferDescriptorWrites[i].dstBinding = 0;
         bladesBufferDescriptorWrites[i].dstArrayElement = 0;
         bladesBufferDescriptorWrites[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
-        bladesBufferDescriptorWrites[i].descriptorCount = 1;
-        bladesBufferDescriptorWrites[i].pBufferInfo = &bladesBufferInfo;
+        bladesBufferDescriptorWrites[i].descriptorCount = 2;
+        bladesBufferDescriptorWrites[i].pBufferInfo = bladesBufferInfos;
         bladesBufferDescriptorWrites[i].pImageInfo = nullptr;
         bladesBufferDescriptorWrites[i].pTexelBufferView = nullptr;
 
 		VkDescriptorBufferInfo culledBladesBufferInfo = {};
 		culledBladesBufferInfo.buffer = scene->GetBlades()[i]->GetCulledBladesBuffer();
 		culledBladesBufferInfo.offset = 0;
-		culledBladesBufferInfo.range = sizeof(Blade) * NUM_BLADES;
+		culledBladesBufferInfo.range = VK_WHOLE_SIZE;
 
 		culledBladesBufferDescriptorWrites[i].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
 		culledBladesBufferDescriptorWrites[i].dstSet = culledBladesBufferDescriptorSets[i];
@@ -672,7 +970,7 @@ void Renderer::CreateComputeDescriptorSets() {
 		VkDescriptorBufferInfo numBladesBufferInfo = {};
 		numBladesBufferInfo.buffer = scene->GetBlades()[i]->GetNumBladesBuffer();
 		numBladesBufferInfo.offset = 0;
-		numBladesBufferInfo.range = sizeof(BladeDrawIndirect);
+		numBladesBufferInfo.range = VK_WHOLE_SIZE;
 
 		numBladesDescriptorWrites[i].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
 		numBladesDescriptorWrites[i].dstSet = numBladesDescriptorSets[i];
@@ -733,25 +1031,29 @@ void Renderer::CreateReedsComputeDescriptorSets()
 
     for (uint32_t i = 0; i < scene->GetReeds().size(); ++i)
     {
-        VkDescriptorBufferInfo bladesBufferInfo = {};
-        bladesBufferInfo.buffer = scene->GetReeds()[i]->GetReedsBuffer();
-        bladesBufferInfo.offset = 0;
-        bladesBufferInfo.range = sizeof(Reed) * scene->GetReeds()[i]->reedsCount;
-
+        VkDescriptorBufferInfo bladesBufferInfos[2] = {};
+        bladesBufferInfos[0].buffer = scene->GetReeds()[i]->GetReedsStaticBuffer();
+        bladesBufferInfos[0].offset = 0;
+        bladesBufferInfos[0].range = VK_WHOLE_SIZE;
+        bladesBufferInfos[1].buffer = scene->GetReeds()[i]->GetReedsDynamicBuffer();
+        bladesBufferInfos[1].offset = 0;
+        bladesBufferInfos[1].range = VK_WHOLE_SIZE;
+
+        // Both bindings are consecutive, so a single write covers them
         bladesBufferDescriptorWrites[i].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
         bladesBufferDescriptorWrites[i].dstSet = reedsBufferDescriptorSets[i];
         bladesBufferDescriptorWrites[i].dstBinding = 0;
         bladesBufferDescriptorWrites[i].dstArrayElement = 0;
         bladesBufferDescriptorWrites[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
-        bladesBufferDescriptorWrites[i].descriptorCount = 1;
-        bladesBufferDescriptorWrites[i].pBufferInfo = &bladesBufferInfo;
+        bladesBufferDescriptorWrites[i].descriptorCount = 2;
+        bladesBufferDescriptorWrites[i].pBufferInfo = bladesBufferInfos;
         bladesBufferDescriptorWrites[i].pImageInfo = nullptr;
         bladesBufferDescriptorWrites[i].pTexelBufferView = nullptr;
 
         VkDescriptorBufferInfo culledBladesBufferInfo = {};
         culledBladesBufferInfo.buffer = scene->GetReeds()[i]->GetCulledReedsBuffer();
         culledBladesBufferInfo.offset = 0;
-        culledBladesBufferInfo.range = sizeof(Reed) * scene->GetReeds()[i]->reedsCount;
+        culledBladesBufferInfo.range = VK_WHOLE_SIZE;
 
         culledBladesBufferDescriptorWrites[i].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
         culledBladesBufferDescriptorWrites[i].dstSet = culledReedsBufferDescriptorSets[i];
@@ -766,7 +1068,7 @@ void Renderer::CreateReedsComputeDescriptorSets()
         VkDescriptorBufferInfo numBladesBufferInfo = {};
         numBladesBufferInfo.buffer = scene->GetReeds()[i]->GetNumReedsBuffer();
         numBladesBufferInfo.offset = 0;
-        numBladesBufferInfo.range = sizeof(ReedsDrawIndirect);
+        numBladesBufferInfo.range = VK_WHOLE_SIZE;
 
         numBladesDescriptorWrites[i].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
         numBladesDescriptorWrites[i].dstSet = numReedsDescriptorSets[i];
@@ -897,12 +1199,18 @@ void Renderer::CreateNoiseMapDescriptorSet()
 	vkDestroyCommandPool(device->GetVkDevice(), transferCommandPool, nullptr);
 
 
-    std::vector<VkWriteDescriptorSet> descriptorWrites(1);
+    std::vector<VkWriteDescriptorSet> descriptorWrites(2);
     VkDescriptorImageInfo imageInfo = {};
     imageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
     imageInfo.imageView = noiseImageView;
     imageInfo.sampler = noiseSampler;
 
+    // Repeats like the noise it is built from, so it shares the sampler
+    VkDescriptorImageInfo windInfo = {};
+    windInfo.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+    windInfo.imageView = windFieldImageView;
+    windInfo.sampler = noiseSampler;
+
     descriptorWrites[0].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
     descriptorWrites[0].dstSet = noiseMapDescriptorSet;
     descriptorWrites[0].dstBinding = 0;
@@ -911,7 +1219,43 @@ void Renderer::CreateNoiseMapDescriptorSet()
     descriptorWrites[0].descriptorCount = 1;
     descriptorWrites[0].pImageInfo = &imageInfo;
 
-    vkUpdateDescriptorSets(logicalDevice, 1, &descriptorWrites[0], 0, nullptr);
+    descriptorWrites[1].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    descriptorWrites[1].dstSet = noiseMapDescriptorSet;
+    descriptorWrites[1].dstBinding = 1;
+    descriptorWrites[1].dstArrayElement = 0;
+    descriptorWrites[1].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    descriptorWrites[1].descriptorCount = 1;
+    descriptorWrites[1].pImageInfo = &windInfo;
+
+    vkUpdateDescriptorSets(logicalDevice, static_cast<uint32_t>(descriptorWrites.size()), descriptorWrites.data(), 0, nullptr);
+}
+
+void Renderer::CreateWindFieldDescriptorSet() {
+    VkDescriptorSetAllocateInfo allocInfo = {};
+    allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    allocInfo.descriptorPool = descriptorPool;
+    allocInfo.descriptorSetCount = 1;
+    allocInfo.pSetLayouts = &windFieldDescriptorSetLayout;
+
+    if (vkAllocateDescriptorSets(logicalDevice, &allocInfo, &windFieldDescriptorSet) != VK_SUCCESS) {
+        throw std::runtime_error("Failed to allocate descriptor set");
+    }
+
+    VkDescriptorImageInfo imageInfo = {};
+    imageInfo.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+    imageInfo.imageView = windFieldImageView;
+    imageInfo.sampler = VK_NULL_HANDLE;
+
+    VkWriteDescriptorSet descriptorWrite = {};
+    descriptorWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    descriptorWrite.dstSet = windFieldDescriptorSet;
+    descriptorWrite.dstBinding = 0;
+    descriptorWrite.dstArrayElement = 0;
+    descriptorWrite.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+    descriptorWrite.descriptorCount = 1;
+    descriptorWrite.pImageInfo = &imageInfo;
+
+    vkUpdateDescriptorSets(logicalDevice, 1, &descriptorWrite, 0, nullptr);
 }
 
 void Renderer::CreateGraphicsPipeline() {
@@ -1065,7 +1409,7 @@ void Renderer::CreateGraphicsPipeline() {
     pipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
     pipelineInfo.basePipelineIndex = -1;
 
-    if (vkCreateGraphicsPipelines(logicalDevice, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &graphicsPipeline) != VK_SUCCESS) {
+    if (vkCreateGraphicsPipelines(logicalDevice, pipelineCache, 1, &pipelineInfo, nullptr, &graphicsPipeline) != VK_SUCCESS) {
         throw std::runtime_error("Failed to create graphics pipeline");
     }
 
@@ -1113,11 +1457,11 @@ void Renderer::CreateGrassPipeline() {
     VkPipelineVertexInputStateCreateInfo vertexInputInfo = {};
     vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
 
-    auto bindingDescription = Blade::getBindingDescription();
+    auto bindingDescriptions = Blade::getBindingDescriptions();
     auto attributeDescriptions = Blade::getAttributeDescriptions();
 
-    vertexInputInfo.vertexBindingDescriptionCount = 1;
-    vertexInputInfo.pVertexBindingDescriptions = &bindingDescription;
+    vertexInputInfo.vertexBindingDescriptionCount = static_cast<uint32_t>(bindingDescriptions.size());
+    vertexInputInfo.pVertexBindingDescriptions = bindingDescriptions.data();
     vertexInputInfo.vertexAttributeDescriptionCount = static_cast<uint32_t>(attributeDescriptions.size());
     vertexInputInfo.pVertexAttributeDescriptions = attributeDescriptions.data();
 
@@ -1247,7 +1591,7 @@ void Renderer::CreateGrassPipeline() {
     pipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
     pipelineInfo.basePipelineIndex = -1;
 
-    if (vkCreateGraphicsPipelines(logicalDevice, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &grassPipeline) != VK_SUCCESS) {
+    if (vkCreateGraphicsPipelines(logicalDevice, pipelineCache, 1, &pipelineInfo, nullptr, &grassPipeline) != VK_SUCCESS) {
         throw std::runtime_error("Failed to create graphics pipeline");
     }
 
@@ -1268,16 +1612,31 @@ void Renderer::CreateComputePipeline() {
     computeShaderStageInfo.module = computeShaderModule;
     computeShaderStageInfo.pName = "main";
 
+    // Workgroup size is specialization constant 0
+    VkSpecializationMapEntry specializationEntry = { 0, 0, sizeof(uint32_t) };
+    VkSpecializationInfo specializationInfo = {};
+    specializationInfo.mapEntryCount = 1;
+    specializationInfo.pMapEntries = &specializationEntry;
+    specializationInfo.dataSize = sizeof(uint32_t);
+    specializationInfo.pData = &workgroupSize;
+    computeShaderStageInfo.pSpecializationInfo = &specializationInfo;
+
     std::vector<VkDescriptorSetLayout> descriptorSetLayouts = { cameraDescriptorSetLayout, timeDescriptorSetLayout,
         bladesBufferDescriptorSetLayout, culledBladesBufferDescriptorSetLayout, numBladesDescriptorSetLayout, noiseMapDescriptorSetLayout};
 
+    // Number of blades in the bound tile and the culled range of each variant
+    VkPushConstantRange push_constant;
+    push_constant.offset = 0;
+    push_constant.size = sizeof(SimulationParams);
+    push_constant.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+
     // Create pipeline layout
     VkPipelineLayoutCreateInfo pipelineLayoutInfo = {};
     pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
     pipelineLayoutInfo.setLayoutCount = static_cast<uint32_t>(descriptorSetLayouts.size());
     pipelineLayoutInfo.pSetLayouts = descriptorSetLayouts.data();
-    pipelineLayoutInfo.pushConstantRangeCount = 0;
-    pipelineLayoutInfo.pPushConstantRanges = 0;
+    pipelineLayoutInfo.pushConstantRangeCount = 1;
+    pipelineLayoutInfo.pPushConstantRanges = &push_constant;
 
     if (vkCreatePipelineLayout(logicalDevice, &pipelineLayoutInfo, nullptr, &computePipelineLayout) != VK_SUCCESS) {
         throw std::runtime_error("Failed to create pipeline layout");
@@ -1293,7 +1652,7 @@ void Renderer::CreateComputePipeline() {
     pipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
     pipelineInfo.basePipelineIndex = -1;
 
-    if (vkCreateComputePipelines(logicalDevice, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &computePipeline) != VK_SUCCESS) {
+    if (vkCreateComputePipelines(logicalDevice, pipelineCache, 1, &pipelineInfo, nullptr, &computePipeline) != VK_SUCCESS) {
         throw std::runtime_error("Failed to create compute pipeline");
     }
 
@@ -1301,6 +1660,140 @@ void Renderer::CreateComputePipeline() {
     vkDestroyShaderModule(logicalDevice, computeShaderModule, nullptr);
 }
 
+void Renderer::CreateGeneratePipeline() {
+    // Set up programmable shaders
+    VkShaderModule generateShaderModule = ShaderModule::Create("shaders/generate.comp.spv", logicalDevice);
+
+    VkPipelineShaderStageCreateInfo generateShaderStageInfo = {};
+    generateShaderStageInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    generateShaderStageInfo.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+    generateShaderStageInfo.module = generateShaderModule;
+    generateShaderStageInfo.pName = "main";
+
+    // Workgroup size is specialization constant 0
+    VkSpecializationMapEntry specializationEntry = { 0, 0, sizeof(uint32_t) };
+    VkSpecializationInfo specializationInfo = {};
+    specializationInfo.mapEntryCount = 1;
+    specializationInfo.pMapEntries = &specializationEntry;
+    specializationInfo.dataSize = sizeof(uint32_t);
+    specializationInfo.pData = &workgroupSize;
+    generateShaderStageInfo.pSpecializationInfo = &specializationInfo;
+
+    std::vector<VkDescriptorSetLayout> descriptorSetLayouts = { bladesBufferDescriptorSetLayout };
+
+    // Tile offset and seed are pushed per dispatch
+    VkPushConstantRange push_constant;
+    push_constant.offset = 0;
+    push_constant.size = sizeof(BladeGenerationParams);
+    push_constant.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+
+    // Create pipeline layout
+    VkPipelineLayoutCreateInfo pipelineLayoutInfo = {};
+    pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    pipelineLayoutInfo.setLayoutCount = static_cast<uint32_t>(descriptorSetLayouts.size());
+    pipelineLayoutInfo.pSetLayouts = descriptorSetLayouts.data();
+    pipelineLayoutInfo.pushConstantRangeCount = 1;
+    pipelineLayoutInfo.pPushConstantRanges = &push_constant;
+
+    if (vkCreatePipelineLayout(logicalDevice, &pipelineLayoutInfo, nullptr, &generatePipelineLayout) != VK_SUCCESS) {
+        throw std::runtime_error("Failed to create pipeline layout");
+    }
+
+    // Create compute pipeline
+    VkComputePipelineCreateInfo pipelineInfo = {};
+    pipelineInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+    pipelineInfo.stage = generateShaderStageInfo;
+    pipelineInfo.layout = generatePipelineLayout;
+    pipelineInfo.pNext = nullptr;
+    pipelineInfo.flags = 0;
+    pipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
+    pipelineInfo.basePipelineIndex = -1;
+
+    if (vkCreateComputePipelines(logicalDevice, pipelineCache, 1, &pipelineInfo, nullptr, &generatePipeline) != VK_SUCCESS) {
+        throw std::runtime_error("Failed to create compute pipeline");
+    }
+
+    // No need for shader modules anymore
+    vkDestroyShaderModule(logicalDevice, generateShaderModule, nullptr);
+}
+
+void Renderer::CreateWindPipeline() {
+    VkShaderModule windShaderModule = ShaderModule::Create("shaders/wind.comp.spv", logicalDevice);
+
+    VkPipelineShaderStageCreateInfo windShaderStageInfo = {};
+    windShaderStageInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    windShaderStageInfo.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+    windShaderStageInfo.module = windShaderModule;
+    windShaderStageInfo.pName = "main";
+
+    std::vector<VkDescriptorSetLayout> descriptorSetLayouts = { timeDescriptorSetLayout, noiseMapDescriptorSetLayout, windFieldDescriptorSetLayout };
+
+    VkPipelineLayoutCreateInfo pipelineLayoutInfo = {};
+    pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    pipelineLayoutInfo.setLayoutCount = static_cast<uint32_t>(descriptorSetLayouts.size());
+    pipelineLayoutInfo.pSetLayouts = descriptorSetLayouts.data();
+    pipelineLayoutInfo.pushConstantRangeCount = 0;
+    pipelineLayoutInfo.pPushConstantRanges = nullptr;
+
+    if (vkCreatePipelineLayout(logicalDevice, &pipelineLayoutInfo, nullptr, &windPipelineLayout) != VK_SUCCESS) {
+        throw std::runtime_error("Failed to create pipeline layout");
+    }
+
+    VkComputePipelineCreateInfo pipelineInfo = {};
+    pipelineInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+    pipelineInfo.stage = windShaderStageInfo;
+    pipelineInfo.layout = windPipelineLayout;
+    pipelineInfo.pNext = nullptr;
+    pipelineInfo.flags = 0;
+    pipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
+    pipelineInfo.basePipelineIndex = -1;
+
+    if (vkCreateComputePipelines(logicalDevice, pipelineCache, 1, &pipelineInfo, nullptr, &windPipeline) != VK_SUCCESS) {
+        throw std::runtime_error("Failed to create compute pipeline");
+    }
+
+    vkDestroyShaderModule(logicalDevice, windShaderModule, nullptr);
+}
+
+void Renderer::CreateColliderPipeline() {
+    VkShaderModule colliderShaderModule = ShaderModule::Create("shaders/colliders.comp.spv", logicalDevice);
+
+    VkPipelineShaderStageCreateInfo colliderShaderStageInfo = {};
+    colliderShaderStageInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    colliderShaderStageInfo.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+    colliderShaderStageInfo.module = colliderShaderModule;
+    colliderShaderStageInfo.pName = "main";
+
+    // Colliders and their grid live in the time set next to the other per-frame data
+    std::vector<VkDescriptorSetLayout> descriptorSetLayouts = { timeDescriptorSetLayout };
+
+    VkPipelineLayoutCreateInfo pipelineLayoutInfo = {};
+    pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    pipelineLayoutInfo.setLayoutCount = static_cast<uint32_t>(descriptorSetLayouts.size());
+    pipelineLayoutInfo.pSetLayouts = descriptorSetLayouts.data();
+    pipelineLayoutInfo.pushConstantRangeCount = 0;
+    pipelineLayoutInfo.pPushConstantRanges = nullptr;
+
+    if (vkCreatePipelineLayout(logicalDevice, &pipelineLayoutInfo, nullptr, &colliderPipelineLayout) != VK_SUCCESS) {
+        throw std::runtime_error("Failed to create pipeline layout");
+    }
+
+    VkComputePipelineCreateInfo pipelineInfo = {};
+    pipelineInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+    pipelineInfo.stage = colliderShaderStageInfo;
+    pipelineInfo.layout = colliderPipelineLayout;
+    pipelineInfo.pNext = nullptr;
+    pipelineInfo.flags = 0;
+    pipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
+    pipelineInfo.basePipelineIndex = -1;
+
+    if (vkCreateComputePipelines(logicalDevice, pipelineCache, 1, &pipelineInfo, nullptr, &colliderPipeline) != VK_SUCCESS) {
+        throw std::runtime_error("Failed to create compute pipeline");
+    }
+
+    vkDestroyShaderModule(logicalDevice, colliderShaderModule, nullptr);
+}
+
 void Renderer::CreateGrassInstancedPipeline()
 {
     // --- Set up programmable shaders ---
@@ -1314,6 +1807,17 @@ void Renderer::CreateGrassInstancedPipeline()
     vertShaderStageInfo.module = vertShaderModule;
     vertShaderStageInfo.pName = "main";
 
+    // The tile of an instance follows from which draw range it lives in.
+    // Tile sizes come from the scene config, so every Blades in the scene shares them
+    const uint32_t bladesPerTile = scene->GetBlades().empty() ? 2 : scene->GetBlades()[0]->GetBladesPerTile();
+    VkSpecializationMapEntry specializationEntry = { 0, 0, sizeof(uint32_t) };
+    VkSpecializationInfo specializationInfo = {};
+    specializationInfo.mapEntryCount = 1;
+    specializationInfo.pMapEntries = &specializationEntry;
+    specializationInfo.dataSize = sizeof(uint32_t);
+    specializationInfo.pData = &bladesPerTile;
+    vertShaderStageInfo.pSpecializationInfo = &specializationInfo;
+
     VkPipelineShaderStageCreateInfo fragShaderStageInfo = {};
     fragShaderStageInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
     fragShaderStageInfo.stage = VK_SHADER_STAGE_FRAGMENT_BIT;
@@ -1430,20 +1934,15 @@ void Renderer::CreateGrassInstancedPipeline()
     colorBlending.blendConstants[3] = 0.0f;
 
     std::vector<VkDescriptorSetLayout> descriptorSetLayouts = { cameraDescriptorSetLayout, modelDescriptorSetLayout,
-        culledBladesBufferDescriptorSetLayout };
-
-    VkPushConstantRange push_constant;
-    push_constant.offset = 0;
-    push_constant.size = sizeof(Theme);
-    push_constant.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+        culledBladesBufferDescriptorSetLayout, bladesBufferDescriptorSetLayout, timeDescriptorSetLayout };
 
     // Pipeline layout: used to specify uniform values
     VkPipelineLayoutCreateInfo pipelineLayoutInfo = {};
     pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
     pipelineLayoutInfo.setLayoutCount = static_cast<uint32_t>(descriptorSetLayouts.size());
     pipelineLayoutInfo.pSetLayouts = descriptorSetLayouts.data();
-    pipelineLayoutInfo.pushConstantRangeCount = 1;
-    pipelineLayoutInfo.pPushConstantRanges = &push_constant;
+    pipelineLayoutInfo.pushConstantRangeCount = 0;
+    pipelineLayoutInfo.pPushConstantRanges = nullptr;
 
     if (vkCreatePipelineLayout(logicalDevice, &pipelineLayoutInfo, nullptr, &grassInstancedPipelineLayout) != VK_SUCCESS) {
         throw std::runtime_error("Failed to create pipeline layout");
@@ -1468,7 +1967,7 @@ void Renderer::CreateGrassInstancedPipeline()
     pipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
     pipelineInfo.basePipelineIndex = -1;
 
-    if (vkCreateGraphicsPipelines(logicalDevice, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &grassInstancedPipeline) != VK_SUCCESS) {
+    if (vkCreateGraphicsPipelines(logicalDevice, pipelineCache, 1, &pipelineInfo, nullptr, &grassInstancedPipeline) != VK_SUCCESS) {
         throw std::runtime_error("Failed to create graphics pipeline");
     }
 
@@ -1490,6 +1989,23 @@ void Renderer::CreateReedInstancedPipeline()
     vertShaderStageInfo.module = vertShaderModule;
     vertShaderStageInfo.pName = "main";
 
+    // The tile and LOD of an instance follow from which draw range it lives in
+    const uint32_t reedsPerTile = scene->GetReeds().empty() ? 2 : scene->GetReeds()[0]->GetReedsPerTile();
+    const uint32_t drawCapacity = scene->GetReeds().empty() ? 2 : scene->GetReeds()[0]->GetDrawCapacity();
+    const uint32_t lodConstants[] = { drawCapacity, REED_LOD_COUNT, reedsPerTile, REED_DRAW_COUNT };
+    VkSpecializationMapEntry specializationEntries[] = {
+        { 0, 0, sizeof(uint32_t) },
+        { 1, sizeof(uint32_t), sizeof(uint32_t) },
+        { 2, 2 * sizeof(uint32_t), sizeof(uint32_t) },
+        { 3, 3 * sizeof(uint32_t), sizeof(uint32_t) },
+    };
+    VkSpecializationInfo specializationInfo = {};
+    specializationInfo.mapEntryCount = 4;
+    specializationInfo.pMapEntries = specializationEntries;
+    specializationInfo.dataSize = sizeof(lodConstants);
+    specializationInfo.pData = lodConstants;
+    vertShaderStageInfo.pSpecializationInfo = &specializationInfo;
+
     VkPipelineShaderStageCreateInfo fragShaderStageInfo = {};
     fragShaderStageInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
     fragShaderStageInfo.stage = VK_SHADER_STAGE_FRAGMENT_BIT;
@@ -1513,13 +2029,13 @@ void Renderer::CreateReedInstancedPipeline()
     std::array<VkVertexInputAttributeDescription, 2> attributeDescriptions = {};
     attributeDescriptions[0].binding = 0;
     attributeDescriptions[0].location = 0;
-    attributeDescriptions[0].format = VK_FORMAT_R32G32B32A32_SFLOAT;
-    attributeDescriptions[0].offset = 0;
+    attributeDescriptions[0].format = VK_FORMAT_R16G16B16A16_SFLOAT;
+    attributeDescriptions[0].offset = offsetof(ReedVertex, pos);
 
     attributeDescriptions[1].binding = 0;
     attributeDescriptions[1].location = 1;
-    attributeDescriptions[1].format = VK_FORMAT_R32G32B32A32_SFLOAT;
-    attributeDescriptions[1].offset = sizeof(glm::vec4);
+    attributeDescriptions[1].format = VK_FORMAT_R16G16B16A16_SNORM;
+    attributeDescriptions[1].offset = offsetof(ReedVertex, normal);
 
     vertexInputInfo.vertexBindingDescriptionCount = 1;
     vertexInputInfo.pVertexBindingDescriptions = &bindingDescription;
@@ -1614,20 +2130,16 @@ void Renderer::CreateReedInstancedPipeline()
     std::vector<VkDescriptorSetLayout> descriptorSetLayouts = { cameraDescriptorSetLayout,
         culledBladesBufferDescriptorSetLayout,
         timeDescriptorSetLayout,
-        noiseMapDescriptorSetLayout };
-
-    VkPushConstantRange push_constant;
-    push_constant.offset = 0;
-    push_constant.size = sizeof(Theme);
-    push_constant.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+        noiseMapDescriptorSetLayout,
+        bladesBufferDescriptorSetLayout };
 
     // Pipeline layout: used to specify uniform values
     VkPipelineLayoutCreateInfo pipelineLayoutInfo = {};
     pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
     pipelineLayoutInfo.setLayoutCount = static_cast<uint32_t>(descriptorSetLayouts.size());
     pipelineLayoutInfo.pSetLayouts = descriptorSetLayouts.data();
-    pipelineLayoutInfo.pushConstantRangeCount = 1;
-	pipelineLayoutInfo.pPushConstantRanges = &push_constant;
+    pipelineLayoutInfo.pushConstantRangeCount = 0;
+	pipelineLayoutInfo.pPushConstantRanges = nullptr;
 
     if (vkCreatePipelineLayout(logicalDevice, &pipelineLayoutInfo, nullptr, &reedInstancedPipelineLayout) != VK_SUCCESS) {
         throw std::runtime_error("Failed to create pipeline layout");
@@ -1652,7 +2164,7 @@ void Renderer::CreateReedInstancedPipeline()
     pipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
     pipelineInfo.basePipelineIndex = -1;
 
-    if (vkCreateGraphicsPipelines(logicalDevice, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &reedInstancedPipeline) != VK_SUCCESS) {
+    if (vkCreateGraphicsPipelines(logicalDevice, pipelineCache, 1, &pipelineInfo, nullptr, &reedInstancedPipeline) != VK_SUCCESS) {
         throw std::runtime_error("Failed to create graphics pipeline");
     }
 
@@ -1779,18 +2291,13 @@ void Renderer::CreatePostProcessPipeline()
     std::vector<VkDescriptorSetLayout> descriptorSetLayouts = 
     { cameraDescriptorSetLayout, colorDepthDescriptorSetLayout, timeDescriptorSetLayout, noiseMapDescriptorSetLayout };
 
-    VkPushConstantRange push_constant;
-    push_constant.offset = 0;
-    push_constant.size = sizeof(Theme);
-    push_constant.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
-
     // Pipeline layout: used to specify uniform values
     VkPipelineLayoutCreateInfo pipelineLayoutInfo = {};
     pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
     pipelineLayoutInfo.setLayoutCount = static_cast<uint32_t>(descriptorSetLayouts.size());
     pipelineLayoutInfo.pSetLayouts = descriptorSetLayouts.data();
-    pipelineLayoutInfo.pushConstantRangeCount = 1;
-	pipelineLayoutInfo.pPushConstantRanges = &push_constant;
+    pipelineLayoutInfo.pushConstantRangeCount = 0;
+	pipelineLayoutInfo.pPushConstantRanges = nullptr;
 
     if (vkCreatePipelineLayout(logicalDevice, &pipelineLayoutInfo, nullptr, &postProcessPipelineLayout) != VK_SUCCESS) {
         throw std::runtime_error("Failed to create pipeline layout");
@@ -1815,12 +2322,25 @@ void Renderer::CreatePostProcessPipeline()
     pipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
     pipelineInfo.basePipelineIndex = -1;
 
-    auto result = vkCreateGraphicsPipelines(logicalDevice, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &postProcessPipeline);
+    auto result = vkCreateGraphicsPipelines(logicalDevice, pipelineCache, 1, &pipelineInfo, nullptr, &postProcessPipeline);
 
     vkDestroyShaderModule(logicalDevice, vertShaderModule, nullptr);
     vkDestroyShaderModule(logicalDevice, fragShaderModule, nullptr);
 }
 
+// Each creator only writes its own layout and pipeline, and the pipeline cache is
+// internally synchronized, so they can load SPIR-V and compile side by side
+void Renderer::CreatePipelinesParallel(std::initializer_list<void (Renderer::*)()> creators) {
+    std::vector<std::future<void>> tasks;
+    for (auto create : creators) {
+        tasks.push_back(std::async(std::launch::async, create, this));
+    }
+    // Join everything before recording, get() rethrows the first failure
+    for (auto& task : tasks) {
+        task.get();
+    }
+}
+
 void Renderer::CreateFrameResources() {
     imageViews.resize(swapChain->GetCount());
 
@@ -1952,15 +2472,18 @@ void Renderer::DestroyFrameResources() {
     }
 
     vkDestroyImageView(logicalDevice, depthImageView, nullptr);
+    device->RecordFree(depthImageMemory);
     vkFreeMemory(logicalDevice, depthImageMemory, nullptr);
     vkDestroyImage(logicalDevice, depthImage, nullptr);
 
     vkDestroyImageView(logicalDevice, colorImageView, nullptr);
+    device->RecordFree(colorImageMemory);
     vkFreeMemory(logicalDevice, colorImageMemory, nullptr);
     vkDestroyImage(logicalDevice, colorImage, nullptr);
 	vkDestroySampler(logicalDevice, colorSampler, nullptr);
 
 	vkDestroyImageView(logicalDevice, resultImageView, nullptr);
+	device->RecordFree(resultImageMemory);
 	vkFreeMemory(logicalDevice, resultImageMemory, nullptr);
 	vkDestroyImage(logicalDevice, resultImage, nullptr);
 
@@ -1971,6 +2494,9 @@ void Renderer::DestroyFrameResources() {
 }
 
 void Renderer::RecreateFrameResources() {
+    // Frames in flight may still use the old pipelines and framebuffers
+    vkDeviceWaitIdle(logicalDevice);
+
     vkDestroyPipeline(logicalDevice, graphicsPipeline, nullptr);
     vkDestroyPipeline(logicalDevice, grassPipeline, nullptr);
     vkDestroyPipeline(logicalDevice, grassInstancedPipeline, nullptr);
@@ -1979,426 +2505,585 @@ void Renderer::RecreateFrameResources() {
     vkDestroyPipelineLayout(logicalDevice, grassPipelineLayout, nullptr);
 	vkDestroyPipelineLayout(logicalDevice, grassInstancedPipelineLayout, nullptr);
 	vkDestroyPipelineLayout(logicalDevice, reedInstancedPipelineLayout, nullptr);
-    
-    vkFreeCommandBuffers(logicalDevice, graphicsCommandPool, static_cast<uint32_t>(commandBuffers.size()), commandBuffers.data());
 
     DestroyFrameResources();
     CreateFrameResources();
-    CreateGraphicsPipeline();
-    CreateGrassPipeline();
-	CreateGrassInstancedPipeline();
-    //RecordCommandBuffers();
-	RecordGrassCommandBuffer();
-	RecordPostProcessCommandBuffer();
+    auto pipelineStart = std::chrono::high_resolution_clock::now();
+    CreatePipelinesParallel({
+        &Renderer::CreateGraphicsPipeline,
+        &Renderer::CreateGrassPipeline,
+        &Renderer::CreateGrassInstancedPipeline,
+        &Renderer::CreateReedInstancedPipeline,
+    });
+    std::chrono::duration<double, std::milli> pipelineTime = std::chrono::high_resolution_clock::now() - pipelineStart;
+    std::cout << "Recreated pipelines in " << pipelineTime.count() << " ms" << std::endl;
 }
 
-void Renderer::RecordComputeCommandBuffer() {
-    // Specify the command pool and number of buffers to allocate
+void Renderer::GenerateBlades() {
+    std::vector<uint32_t> pending;
+    for (uint32_t i = 0; i < scene->GetBlades().size(); ++i) {
+        if (scene->GetBlades()[i]->NeedsGeneration()) {
+            pending.push_back(i);
+        }
+    }
+    if (pending.empty()) return;
+
     VkCommandBufferAllocateInfo allocInfo = {};
     allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
     allocInfo.commandPool = computeCommandPool;
     allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
     allocInfo.commandBufferCount = 1;
 
-    if (vkAllocateCommandBuffers(logicalDevice, &allocInfo, &computeCommandBuffer) != VK_SUCCESS) {
+    VkCommandBuffer commandBuffer;
+    if (vkAllocateCommandBuffers(logicalDevice, &allocInfo, &commandBuffer) != VK_SUCCESS) {
         throw std::runtime_error("Failed to allocate command buffers");
     }
 
     VkCommandBufferBeginInfo beginInfo = {};
     beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
-    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_SIMULTANEOUS_USE_BIT;
-    beginInfo.pInheritanceInfo = nullptr;
+    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
 
-    // ~ Start recording ~
-    if (vkBeginCommandBuffer(computeCommandBuffer, &beginInfo) != VK_SUCCESS) {
-        throw std::runtime_error("Failed to begin recording compute command buffer");
+    if (vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS) {
+        throw std::runtime_error("Failed to begin recording generate command buffer");
     }
 
-    // Bind to the compute pipeline
-    vkCmdBindPipeline(computeCommandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, computePipeline);
+    vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, generatePipeline);
 
-    // Bind camera descriptor set
-    vkCmdBindDescriptorSets(computeCommandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, computePipelineLayout, 0, 1, &cameraDescriptorSet, 0, nullptr);
-
-    // Bind descriptor set for time uniforms
-    vkCmdBindDescriptorSets(computeCommandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, computePipelineLayout, 1, 1, &timeDescriptorSet, 0, nullptr);
-
-    // Bind descriptor set for noise
-    vkCmdBindDescriptorSets(computeCommandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, computePipelineLayout, 5, 1, &noiseMapDescriptorSet, 0, nullptr);
+    // One dispatch per tile, each writes straight into its range of the shared blades buffer
+    for (uint32_t i : pending) {
+        vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, generatePipelineLayout, 0, 1, &bladesBufferDescriptorSets[i], 0, nullptr);
+        for (const BladeGenerationParams& params : scene->GetBlades()[i]->GetGenerationParams()) {
+            vkCmdPushConstants(commandBuffer, generatePipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(BladeGenerationParams), &params);
+            vkCmdDispatch(commandBuffer, (params.bladeCount + workgroupSize - 1) / workgroupSize, 1, 1);
+        }
+    }
 
-    // TODO: For each group of blades bind its descriptor set and dispatch
-	uint32_t groupCnt = glm::ceil(NUM_BLADES / 32);
-	for (uint32_t i = 0; i < scene->GetBlades().size(); ++i) {
-		vkCmdBindDescriptorSets(computeCommandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, computePipelineLayout, 2, 1, &bladesBufferDescriptorSets[i], 0, nullptr);
-		vkCmdBindDescriptorSets(computeCommandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, computePipelineLayout, 3, 1, &culledBladesBufferDescriptorSets[i], 0, nullptr);
-		vkCmdBindDescriptorSets(computeCommandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, computePipelineLayout, 4, 1, &numBladesDescriptorSets[i], 0, nullptr);
+    if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS) {
+        throw std::runtime_error("Failed to record generate command buffer");
+    }
 
-		vkCmdDispatch(computeCommandBuffer, groupCnt, 1, 1);
-	}
+    VkSubmitInfo submitInfo = {};
+    submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submitInfo.commandBufferCount = 1;
+    submitInfo.pCommandBuffers = &commandBuffer;
 
-    
-    for (uint32_t i = 0; i < scene->GetReeds().size(); ++i) {
-        vkCmdBindDescriptorSets(computeCommandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, computePipelineLayout, 2, 1, &reedsBufferDescriptorSets[i], 0, nullptr);
-        vkCmdBindDescriptorSets(computeCommandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, computePipelineLayout, 3, 1, &culledReedsBufferDescriptorSets[i], 0, nullptr);
-        vkCmdBindDescriptorSets(computeCommandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, computePipelineLayout, 4, 1, &numReedsDescriptorSets[i], 0, nullptr);
-        groupCnt = glm::ceil(scene->GetReeds()[i]->reedsCount / 32);
-        vkCmdDispatch(computeCommandBuffer, groupCnt, 1, 1);
+    if (vkQueueSubmit(device->GetQueue(QueueFlags::Compute), 1, &submitInfo, VK_NULL_HANDLE) != VK_SUCCESS) {
+        throw std::runtime_error("Failed to submit generate command buffer");
     }
+    vkQueueWaitIdle(device->GetQueue(QueueFlags::Compute));
+    vkFreeCommandBuffers(logicalDevice, computeCommandPool, 1, &commandBuffer);
 
-    // ~ End recording ~
-    if (vkEndCommandBuffer(computeCommandBuffer) != VK_SUCCESS) {
-        throw std::runtime_error("Failed to record compute command buffer");
+    for (uint32_t i : pending) {
+        scene->GetBlades()[i]->MarkGenerated();
     }
 }
 
-void Renderer::RecordGrassCommandBuffer()
-{
-    commandBuffers.resize(swapChain->GetCount());
-	
-    // Specify the command pool and number of buffers to allocate
-    VkCommandBufferAllocateInfo allocInfo = {};
-    allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
-    allocInfo.commandPool = graphicsCommandPool;
-    allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
-    allocInfo.commandBufferCount = static_cast<uint32_t>(commandBuffers.size());
-
-    if (vkAllocateCommandBuffers(logicalDevice, &allocInfo, commandBuffers.data()) != VK_SUCCESS) {
-        throw std::runtime_error("Failed to allocate command buffers");
-    }
+void Renderer::RecordComputeCommandBuffers() {
+    for (FrameContext& frame : frames) {
+        // Specify the command pool and number of buffers to allocate
+        VkCommandBufferAllocateInfo allocInfo = {};
+        allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+        allocInfo.commandPool = computeCommandPool;
+        allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+        allocInfo.commandBufferCount = 1;
+
+        if (vkAllocateCommandBuffers(logicalDevice, &allocInfo, &frame.computeCommandBuffer) != VK_SUCCESS) {
+            throw std::runtime_error("Failed to allocate command buffers");
+        }
+        VkCommandBuffer computeCommandBuffer = frame.computeCommandBuffer;
 
-    // Start command buffer recording
-    for (size_t i = 0; i < commandBuffers.size(); i++) {
         VkCommandBufferBeginInfo beginInfo = {};
         beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
         beginInfo.flags = VK_COMMAND_BUFFER_USAGE_SIMULTANEOUS_USE_BIT;
         beginInfo.pInheritanceInfo = nullptr;
 
         // ~ Start recording ~
-        if (vkBeginCommandBuffer(commandBuffers[i], &beginInfo) != VK_SUCCESS) {
-            throw std::runtime_error("Failed to begin recording command buffer");
+        if (vkBeginCommandBuffer(computeCommandBuffer, &beginInfo) != VK_SUCCESS) {
+            throw std::runtime_error("Failed to begin recording compute command buffer");
         }
 
-        // Begin the render pass
-        VkRenderPassBeginInfo renderPassInfo = {};
-        renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
-        renderPassInfo.renderPass = renderPass;
-        renderPassInfo.framebuffer = framebuffers[i];
-        renderPassInfo.renderArea.offset = { 0, 0 };
-        renderPassInfo.renderArea.extent = swapChain->GetVkExtent();
-
-        std::array<VkClearValue, 2> clearValues = {};
-        clearValues[0].color = { 0.5f, 0.5f, 0.5f, 0.0f };
-        clearValues[1].depthStencil = { 1.0f, 0 };
-        renderPassInfo.clearValueCount = static_cast<uint32_t>(clearValues.size());
-        renderPassInfo.pClearValues = clearValues.data();
-
-        std::vector<VkBufferMemoryBarrier> barriers(scene->GetBlades().size() + scene->GetReeds().size());
-        for (uint32_t j = 0; j < barriers.size(); ++j) {
-            barriers[j].sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
-            barriers[j].srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
-            barriers[j].dstAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT;
-            barriers[j].srcQueueFamilyIndex = device->GetQueueIndex(QueueFlags::Compute);
-            barriers[j].dstQueueFamilyIndex = device->GetQueueIndex(QueueFlags::Graphics);
-            if (j < scene->GetBlades().size())
-                barriers[j].buffer = scene->GetBlades()[j]->GetNumBladesBuffer();
-            else
-				barriers[j].buffer = scene->GetReeds()[j - scene->GetBlades().size()]->GetNumReedsBuffer();
-            barriers[j].offset = 0;
-            barriers[j].size = sizeof(BladeDrawIndirect);
+        if (timestampQueryPool != VK_NULL_HANDLE) {
+            vkCmdResetQueryPool(computeCommandBuffer, timestampQueryPool, frame.firstQuery + TIMESTAMP_COMPUTE_BEGIN, 2);
+            vkCmdWriteTimestamp(computeCommandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, timestampQueryPool, frame.firstQuery + TIMESTAMP_COMPUTE_BEGIN);
         }
 
-        vkCmdPipelineBarrier(commandBuffers[i], VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT, 0, 0, nullptr, barriers.size(), barriers.data(), 0, nullptr);
-
-        // Bind the camera descriptor set. This is set 0 in all pipelines so it will be inherited
-        vkCmdBindDescriptorSets(commandBuffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, graphicsPipelineLayout, 0, 1, &cameraDescriptorSet, 0, nullptr);
-
-        vkCmdBeginRenderPass(commandBuffers[i], &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
-
-        // Bind the graphics pipeline
-        vkCmdBindPipeline(commandBuffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, graphicsPipeline);
-
-        // Bind the descriptor set for each model
-        vkCmdBindDescriptorSets(commandBuffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, graphicsPipelineLayout, 1, 1, &modelDescriptorSets[0], 0, nullptr);
-
-        for (uint32_t j = 0; j < scene->GetModels().size(); ++j) {
-            // Bind the vertex and index buffers
-            VkBuffer vertexBuffers[] = { scene->GetModels()[j]->getVertexBuffer() };
-            VkDeviceSize offsets[] = { 0 };
-            vkCmdBindVertexBuffers(commandBuffers[i], 0, 1, vertexBuffers, offsets);
-
-            vkCmdBindIndexBuffer(commandBuffers[i], scene->GetModels()[j]->getIndexBuffer(), 0, VK_INDEX_TYPE_UINT32);
-
-            // Bind the descriptor set for each model
-            //vkCmdBindDescriptorSets(commandBuffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, graphicsPipelineLayout, 1, 1, &modelDescriptorSets[j], 0, nullptr);
-
-            // Draw
-            std::vector<uint32_t> indices = scene->GetModels()[j]->getIndices();
-            vkCmdDrawIndexed(commandBuffers[i], static_cast<uint32_t>(indices.size()), 1, 0, 0, 0);
+        // Wind forces for this frame's time, shared by every blade and reed leaf
+        vkCmdBindPipeline(computeCommandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, windPipeline);
+        VkDescriptorSet windSets[] = { timeDescriptorSet, noiseMapDescriptorSet, windFieldDescriptorSet };
+        vkCmdBindDescriptorSets(computeCommandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, windPipelineLayout, 0, 3, windSets, 0, nullptr);
+        uint32_t windGroups = (WIND_FIELD_SIZE + WIND_FIELD_WORKGROUP_SIZE - 1) / WIND_FIELD_WORKGROUP_SIZE;
+        vkCmdDispatch(computeCommandBuffer, windGroups, windGroups, 1);
+
+        // Reset the instance counts of last frame before culling appends to them, one copy covers every tile
+        for (uint32_t i = 0; i < scene->GetBlades().size(); ++i) {
+            VkBufferCopy copyRegion = { 0, 0, scene->GetBlades()[i]->GetTileCount() * sizeof(BladeDrawIndirect) };
+            vkCmdCopyBuffer(computeCommandBuffer, scene->GetBlades()[i]->GetNumBladesResetBuffer(), scene->GetBlades()[i]->GetNumBladesBuffer(), 1, &copyRegion);
+        }
+        for (uint32_t i = 0; i < scene->GetReeds().size(); ++i) {
+            VkBufferCopy copyRegion = { 0, 0, scene->GetReeds()[i]->GetTileCount() * REED_DRAW_COUNT * sizeof(ReedsDrawIndirect) };
+            vkCmdCopyBuffer(computeCommandBuffer, scene->GetReeds()[i]->GetNumReedsResetBuffer(), scene->GetReeds()[i]->GetNumReedsBuffer(), 1, &copyRegion);
+        }
+        vkCmdFillBuffer(computeCommandBuffer, simulationStatsBuffer, frame.statsSlot * sizeof(uint32_t), sizeof(uint32_t), 0);
+        vkCmdFillBuffer(computeCommandBuffer, colliderCellCountBuffer, 0, VK_WHOLE_SIZE, 0);
+
+        // One barrier makes both the resets and the wind field visible to the passes after it
+        VkMemoryBarrier fillBarrier = {};
+        fillBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+        fillBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+        fillBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+        vkCmdPipelineBarrier(computeCommandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &fillBarrier, 0, nullptr, 0, nullptr);
+
+        // Bin the scene's colliders so each blade only tests those in its cell. The count is only
+        // known on the GPU, so enough threads for MAX_COLLIDERS are launched and the rest return
+        vkCmdBindPipeline(computeCommandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, colliderPipeline);
+        vkCmdBindDescriptorSets(computeCommandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, colliderPipelineLayout, 0, 1, &timeDescriptorSet, 0, nullptr);
+        vkCmdDispatch(computeCommandBuffer, (MAX_COLLIDERS + COLLIDER_WORKGROUP_SIZE - 1) / COLLIDER_WORKGROUP_SIZE, 1, 1);
+
+        VkMemoryBarrier binBarrier = {};
+        binBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+        binBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+        binBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+        vkCmdPipelineBarrier(computeCommandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &binBarrier, 0, nullptr, 0, nullptr);
+
+        // Bind to the compute pipeline
+        vkCmdBindPipeline(computeCommandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, computePipeline);
+
+        // Bind camera descriptor set
+        vkCmdBindDescriptorSets(computeCommandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, computePipelineLayout, 0, 1, &cameraDescriptorSet, 0, nullptr);
+
+        // Bind descriptor set for time uniforms
+        vkCmdBindDescriptorSets(computeCommandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, computePipelineLayout, 1, 1, &timeDescriptorSet, 0, nullptr);
+
+        // Bind descriptor set for noise
+        vkCmdBindDescriptorSets(computeCommandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, computePipelineLayout, 5, 1, &noiseMapDescriptorSet, 0, nullptr);
+
+        // Every tile of a kind shares its buffers, so each kind is a single bind and dispatch
+		for (uint32_t i = 0; i < scene->GetBlades().size(); ++i) {
+			uint32_t bladesPerTile = scene->GetBlades()[i]->GetBladesPerTile();
+			SimulationParams bladeParams = { scene->GetBlades()[i]->GetTileCount() * bladesPerTile, bladesPerTile, 1, VISIBLE_GRASS, bladesPerTile, 1, frame.statsSlot };
+			vkCmdBindDescriptorSets(computeCommandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, computePipelineLayout, 2, 1, &bladesBufferDescriptorSets[i], 0, nullptr);
+			vkCmdBindDescriptorSets(computeCommandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, computePipelineLayout, 3, 1, &culledBladesBufferDescriptorSets[i], 0, nullptr);
+			vkCmdBindDescriptorSets(computeCommandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, computePipelineLayout, 4, 1, &numBladesDescriptorSets[i], 0, nullptr);
+			vkCmdPushConstants(computeCommandBuffer, computePipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(SimulationParams), &bladeParams);
+
+			vkCmdDispatch(computeCommandBuffer, (bladeParams.bladeCount + workgroupSize - 1) / workgroupSize, 1, 1);
+		}
+
+        for (uint32_t i = 0; i < scene->GetReeds().size(); ++i) {
+            // Empty slots of sparse tiles have no height and return straight away
+            const Reeds* reeds = scene->GetReeds()[i];
+            uint32_t reedCount = reeds->GetTileCount() * reeds->GetReedsPerTile();
+
+            vkCmdBindDescriptorSets(computeCommandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, computePipelineLayout, 2, 1, &reedsBufferDescriptorSets[i], 0, nullptr);
+            vkCmdBindDescriptorSets(computeCommandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, computePipelineLayout, 3, 1, &culledReedsBufferDescriptorSets[i], 0, nullptr);
+            vkCmdBindDescriptorSets(computeCommandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, computePipelineLayout, 4, 1, &numReedsDescriptorSets[i], 0, nullptr);
+            SimulationParams reedParams = { reedCount, reeds->GetDrawCapacity(), REED_LOD_COUNT, VISIBLE_REEDS, reeds->GetReedsPerTile(), REED_DRAW_COUNT, frame.statsSlot };
+            vkCmdPushConstants(computeCommandBuffer, computePipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(SimulationParams), &reedParams);
+
+            vkCmdDispatch(computeCommandBuffer, (reedCount + workgroupSize - 1) / workgroupSize, 1, 1);
         }
 
-        VkBuffer vertexBuffer;
-        VkBuffer indexBuffer;
-        VkDeviceSize offsets[] = { 0 };
-
-        if (renderGrass)
-        {
-            // Bind the grass pipeline
-            vkCmdBindPipeline(commandBuffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, grassInstancedPipeline);
-            vertexBuffer = Blade::GetBladeVertexBuffer();
-            indexBuffer = Blade::GetBladeIndexBuffer();
-            vkCmdBindVertexBuffers(commandBuffers[i], 0, 1, &vertexBuffer, offsets);
-            vkCmdBindIndexBuffer(commandBuffers[i], indexBuffer, 0, VK_INDEX_TYPE_UINT32);
-
-            vkCmdPushConstants(commandBuffers[i], grassInstancedPipelineLayout, VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(Theme), &scene->theme);
-
-            vkCmdBindDescriptorSets(commandBuffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, grassInstancedPipelineLayout, 0, 1, &cameraDescriptorSet, 0, nullptr);
-
-            vkCmdBindDescriptorSets(commandBuffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, grassInstancedPipelineLayout, 1, 1, &grassDescriptorSets[0], 0, nullptr);
-
-            for (uint32_t j = 0; j < scene->GetBlades().size(); ++j) {
-                // Bind the culled blade descriptor set. This is set 0 in all pipelines so it will be inherited
-                vkCmdBindDescriptorSets(commandBuffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, grassInstancedPipelineLayout, 2, 1, &culledBladesBufferDescriptorSets[j], 0, nullptr);
+        if (timestampQueryPool != VK_NULL_HANDLE) {
+            vkCmdWriteTimestamp(computeCommandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, timestampQueryPool, frame.firstQuery + TIMESTAMP_COMPUTE_END);
+        }
 
-                // Draw
-                vkCmdDrawIndexedIndirect(commandBuffers[i], scene->GetBlades()[j]->GetNumBladesBuffer(), 0, 1, sizeof(BladeDrawIndirect));
-            }
+        // ~ End recording ~
+        if (vkEndCommandBuffer(computeCommandBuffer) != VK_SUCCESS) {
+            throw std::runtime_error("Failed to record compute command buffer");
         }
+    }
+}
 
-        if (renderReeds)
-        {
-            // Bind the reed pipeline
-            vkCmdBindPipeline(commandBuffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, reedInstancedPipeline);
-            vkCmdBindDescriptorSets(commandBuffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, reedInstancedPipelineLayout, 2, 1, &timeDescriptorSet, 0, nullptr);
-            vkCmdBindDescriptorSets(commandBuffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, reedInstancedPipelineLayout, 3, 1, &noiseMapDescriptorSet, 0, nullptr);
-            vertexBuffer = Reed::GetBladeVertexBuffer();
-            indexBuffer = Reed::GetBladeIndexBuffer();
-            vkCmdBindVertexBuffers(commandBuffers[i], 0, 1, &vertexBuffer, offsets);
-            vkCmdBindIndexBuffer(commandBuffers[i], indexBuffer, 0, VK_INDEX_TYPE_UINT32);
+void Renderer::CreateFrameContexts() {
+    uint32_t hardwareThreads = std::max(1u, std::thread::hardware_concurrency());
+    recordingThreads = std::min<uint32_t>(hardwareThreads, MAX_RECORDING_THREADS);
+
+    VkCommandPoolCreateInfo poolInfo = {};
+    poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+    poolInfo.queueFamilyIndex = device->GetInstance()->GetQueueFamilyIndices()[QueueFlags::Graphics];
+    // Buffers are never reset individually, the whole pool is reset once per frame
+    poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+
+    VkFenceCreateInfo fenceInfo = {};
+    fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+    // Start signaled so the first wait on each frame returns immediately
+    fenceInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;
+
+    frames.resize(MAX_FRAMES_IN_FLIGHT);
+    for (uint32_t f = 0; f < frames.size(); ++f) {
+        FrameContext& frame = frames[f];
+        frame.firstQuery = f * TIMESTAMPS_PER_FRAME;
+        frame.statsSlot = f;
+
+        if (vkCreateCommandPool(logicalDevice, &poolInfo, nullptr, &frame.commandPool) != VK_SUCCESS) {
+            throw std::runtime_error("Failed to create command pool");
+        }
 
-            vkCmdPushConstants(commandBuffers[i], grassInstancedPipelineLayout, VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(Theme), &scene->theme);
+        VkCommandBufferAllocateInfo allocInfo = {};
+        allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+        allocInfo.commandPool = frame.commandPool;
+        allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+        allocInfo.commandBufferCount = 1;
 
-            for (uint32_t j = 0; j < scene->GetReeds().size(); ++j) {
+        if (vkAllocateCommandBuffers(logicalDevice, &allocInfo, &frame.commandBuffer) != VK_SUCCESS) {
+            throw std::runtime_error("Failed to allocate command buffers");
+        }
 
-                //vkCmdBindDescriptorSets(commandBuffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, grassInstancedPipelineLayout, 1, 1, &grassDescriptorSets[j], 0, nullptr);
-                // Bind the culled blade descriptor set. This is set 0 in all pipelines so it will be inherited
-                vkCmdBindDescriptorSets(commandBuffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, reedInstancedPipelineLayout, 1, 1, &culledReedsBufferDescriptorSets[j], 0, nullptr);
+        // Command pools are externally synchronized, so every recording thread gets its own
+        frame.workerPools.resize(recordingThreads);
+        frame.workerCommandBuffers.resize(recordingThreads);
+        for (uint32_t t = 0; t < recordingThreads; ++t) {
+            if (vkCreateCommandPool(logicalDevice, &poolInfo, nullptr, &frame.workerPools[t]) != VK_SUCCESS) {
+                throw std::runtime_error("Failed to create command pool");
+            }
 
-                // Draw
-                vkCmdDrawIndexedIndirect(commandBuffers[i], scene->GetReeds()[j]->GetNumReedsBuffer(), 0, 1, sizeof(ReedsDrawIndirect));
+            allocInfo.commandPool = frame.workerPools[t];
+            allocInfo.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+            if (vkAllocateCommandBuffers(logicalDevice, &allocInfo, &frame.workerCommandBuffers[t]) != VK_SUCCESS) {
+                throw std::runtime_error("Failed to allocate command buffers");
             }
         }
-        // End render pass
-        vkCmdEndRenderPass(commandBuffers[i]);
 
+        if (vkCreateFence(logicalDevice, &fenceInfo, nullptr, &frame.inFlightFence) != VK_SUCCESS) {
+            throw std::runtime_error("Failed to create fence");
+        }
+    }
+}
 
-		// Begin the post process render pass
-        VkRenderPassBeginInfo postRenderPassInfo = {};
-        postRenderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
-        postRenderPassInfo.renderPass = postProcessRenderPass;
-        postRenderPassInfo.framebuffer = resultImageFramebuffers[i];
-        postRenderPassInfo.renderArea.offset = { 0, 0 };
-        postRenderPassInfo.renderArea.extent = swapChain->GetVkExtent();
+void Renderer::DestroyFrameContexts() {
+    for (FrameContext& frame : frames) {
+        // Destroying a pool frees the command buffers allocated from it
+        for (VkCommandPool pool : frame.workerPools) {
+            vkDestroyCommandPool(logicalDevice, pool, nullptr);
+        }
+        vkDestroyCommandPool(logicalDevice, frame.commandPool, nullptr);
+        vkDestroyFence(logicalDevice, frame.inFlightFence, nullptr);
+    }
+    frames.clear();
+}
 
-        clearValues[0].color = { 0.0f, 0.0f, 0.0f, 0.0f };
-        postRenderPassInfo.clearValueCount = static_cast<uint32_t>(clearValues.size());
-        postRenderPassInfo.pClearValues = clearValues.data();
+void Renderer::RecordSceneDraws(VkCommandBuffer commandBuffer, uint32_t firstItem, uint32_t lastItem) {
+    // Draw items are the planes, then the grass tiles, then the reed tiles
+    const uint32_t modelCount = static_cast<uint32_t>(scene->GetModels().size());
+    const uint32_t bladesCount = static_cast<uint32_t>(scene->GetBlades().size());
+
+    // Nothing is inherited by a secondary buffer, so bind state lazily when the item kind changes
+    VkPipeline boundPipeline = VK_NULL_HANDLE;
+    VkDeviceSize offsets[] = { 0 };
+
+    for (uint32_t item = firstItem; item < lastItem; ++item) {
+        if (item < modelCount) {
+            Model* model = scene->GetModels()[item];
+            if (boundPipeline != graphicsPipeline) {
+                boundPipeline = graphicsPipeline;
+                vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, graphicsPipeline);
+                vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, graphicsPipelineLayout, 0, 1, &cameraDescriptorSet, 0, nullptr);
+                vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, graphicsPipelineLayout, 1, 1, &modelDescriptorSets[0], 0, nullptr);
+            }
 
-        // Bind the camera descriptor set. This is set 0 in all pipelines so it will be inherited
-        vkCmdBindDescriptorSets(commandBuffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, postProcessPipelineLayout, 0, 1, &cameraDescriptorSet, 0, nullptr);
-        vkCmdBindDescriptorSets(commandBuffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, postProcessPipelineLayout, 1, 1, &colorDepthDescriptorSet, 0, nullptr);
-        vkCmdBindDescriptorSets(commandBuffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, postProcessPipelineLayout, 2, 1, &timeDescriptorSet, 0, nullptr);
-        vkCmdBindDescriptorSets(commandBuffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, postProcessPipelineLayout, 3, 1, &noiseMapDescriptorSet, 0, nullptr);
+            // Bind the vertex and index buffers
+            VkBuffer vertexBuffer = model->getVertexBuffer();
+            vkCmdBindVertexBuffers(commandBuffer, 0, 1, &vertexBuffer, offsets);
+            vkCmdBindIndexBuffer(commandBuffer, model->getIndexBuffer(), 0, VK_INDEX_TYPE_UINT32);
 
-        vkCmdBeginRenderPass(commandBuffers[i], &postRenderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+            // Draw
+            vkCmdDrawIndexed(commandBuffer, static_cast<uint32_t>(model->getIndices().size()), 1, 0, 0, 0);
+        }
+        else if (item < modelCount + bladesCount) {
+            uint32_t j = item - modelCount;
+            if (boundPipeline != grassInstancedPipeline) {
+                boundPipeline = grassInstancedPipeline;
+                vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, grassInstancedPipeline);
+                VkBuffer vertexBuffer = Blade::GetBladeVertexBuffer();
+                vkCmdBindVertexBuffers(commandBuffer, 0, 1, &vertexBuffer, offsets);
+                vkCmdBindIndexBuffer(commandBuffer, Blade::GetBladeIndexBuffer(), 0, VK_INDEX_TYPE_UINT32);
+
+                vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, grassInstancedPipelineLayout, 0, 1, &cameraDescriptorSet, 0, nullptr);
+                vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, grassInstancedPipelineLayout, 1, 1, &grassDescriptorSets[0], 0, nullptr);
+                vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, grassInstancedPipelineLayout, 4, 1, &timeDescriptorSet, 0, nullptr);
+            }
 
-        // Bind the graphics pipeline
-        vkCmdBindPipeline(commandBuffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, postProcessPipeline);
-        vkCmdPushConstants(commandBuffers[i], postProcessPipelineLayout, VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(Theme), &scene->theme);
+            // Bind the culled blades and the blades of this tile
+            vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, grassInstancedPipelineLayout, 2, 1, &culledBladesBufferDescriptorSets[j], 0, nullptr);
+            vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, grassInstancedPipelineLayout, 3, 1, &bladesBufferDescriptorSets[j], 0, nullptr);
 
-        vkCmdDraw(commandBuffers[i], 3, 1, 0, 0);
+            // Draw every tile, one command each
+            uint32_t drawCount = scene->GetBlades()[j]->GetTileCount();
+            if (device->GetEnabledFeatures().multiDrawIndirect) {
+                vkCmdDrawIndexedIndirect(commandBuffer, scene->GetBlades()[j]->GetNumBladesBuffer(), 0, drawCount, sizeof(BladeDrawIndirect));
+            }
+            else {
+                for (uint32_t d = 0; d < drawCount; ++d) {
+                    vkCmdDrawIndexedIndirect(commandBuffer, scene->GetBlades()[j]->GetNumBladesBuffer(), d * sizeof(BladeDrawIndirect), 1, sizeof(BladeDrawIndirect));
+                }
+            }
+        }
+        else {
+            uint32_t j = item - modelCount - bladesCount;
+            if (boundPipeline != reedInstancedPipeline) {
+                boundPipeline = reedInstancedPipeline;
+                vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, reedInstancedPipeline);
+                VkBuffer vertexBuffer = Reed::GetBladeVertexBuffer();
+                vkCmdBindVertexBuffers(commandBuffer, 0, 1, &vertexBuffer, offsets);
+                vkCmdBindIndexBuffer(commandBuffer, Reed::GetBladeIndexBuffer(), 0, VK_INDEX_TYPE_UINT32);
+
+                vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, reedInstancedPipelineLayout, 0, 1, &cameraDescriptorSet, 0, nullptr);
+                vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, reedInstancedPipelineLayout, 2, 1, &timeDescriptorSet, 0, nullptr);
+                vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, reedInstancedPipelineLayout, 3, 1, &noiseMapDescriptorSet, 0, nullptr);
+            }
 
-        // End render pass
-        vkCmdEndRenderPass(commandBuffers[i]);
+            // Bind the culled reeds and the reeds of this tile
+            vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, reedInstancedPipelineLayout, 1, 1, &culledReedsBufferDescriptorSets[j], 0, nullptr);
+            vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, reedInstancedPipelineLayout, 4, 1, &reedsBufferDescriptorSets[j], 0, nullptr);
 
-        // ~ End recording ~
-        if (vkEndCommandBuffer(commandBuffers[i]) != VK_SUCCESS) {
-            throw std::runtime_error("Failed to record command buffer");
+            // Draw every tile, variant and LOD, one command each
+            uint32_t drawCount = scene->GetReeds()[j]->GetTileCount() * REED_DRAW_COUNT;
+            if (device->GetEnabledFeatures().multiDrawIndirect) {
+                vkCmdDrawIndexedIndirect(commandBuffer, scene->GetReeds()[j]->GetNumReedsBuffer(), 0, drawCount, sizeof(ReedsDrawIndirect));
+            }
+            else {
+                for (uint32_t d = 0; d < drawCount; ++d) {
+                    vkCmdDrawIndexedIndirect(commandBuffer, scene->GetReeds()[j]->GetNumReedsBuffer(), d * sizeof(ReedsDrawIndirect), 1, sizeof(ReedsDrawIndirect));
+                }
+            }
         }
     }
 }
 
-void Renderer::RecordPostProcessCommandBuffer()
-{
-    postCommandBuffers.resize(swapChain->GetCount());
+void Renderer::RecordFrameCommandBuffer(FrameContext& frame, uint32_t imageIndex) {
+    // The GPU is done with this frame, so everything allocated from its pools can be recycled at once
+    vkResetCommandPool(logicalDevice, frame.commandPool, 0);
+    for (VkCommandPool pool : frame.workerPools) {
+        vkResetCommandPool(logicalDevice, pool, 0);
+    }
 
-    // Specify the command pool and number of buffers to allocate
-    VkCommandBufferAllocateInfo allocInfo = {};
-    allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
-    allocInfo.commandPool = graphicsCommandPool;
-    allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
-    allocInfo.commandBufferCount = static_cast<uint32_t>(postCommandBuffers.size());
+    // Split the tiles into contiguous chunks, one secondary command buffer per recording thread.
+    // Hidden grass or reeds are dropped by the cull pass, so their draws simply have no instances
+    const uint32_t itemCount = static_cast<uint32_t>(scene->GetModels().size() + scene->GetBlades().size() + scene->GetReeds().size());
+    const uint32_t itemsPerThread = (itemCount + recordingThreads - 1) / recordingThreads;
 
-    if (vkAllocateCommandBuffers(logicalDevice, &allocInfo, postCommandBuffers.data()) != VK_SUCCESS) {
-        throw std::runtime_error("Failed to allocate command buffers");
-    }
+    VkCommandBufferInheritanceInfo inheritanceInfo = {};
+    inheritanceInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+    inheritanceInfo.renderPass = renderPass;
+    inheritanceInfo.subpass = 0;
+    inheritanceInfo.framebuffer = framebuffers[imageIndex];
+
+    auto recordChunk = [&](uint32_t t) {
+        VkCommandBuffer commandBuffer = frame.workerCommandBuffers[t];
 
-    // Start command buffer recording
-    for (size_t i = 0; i < postCommandBuffers.size(); i++) {
         VkCommandBufferBeginInfo beginInfo = {};
         beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
-        beginInfo.flags = VK_COMMAND_BUFFER_USAGE_SIMULTANEOUS_USE_BIT;
-        beginInfo.pInheritanceInfo = nullptr;
+        beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT | VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
+        beginInfo.pInheritanceInfo = &inheritanceInfo;
 
-        // ~ Start recording ~
-        if (vkBeginCommandBuffer(postCommandBuffers[i], &beginInfo) != VK_SUCCESS) {
+        if (vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS) {
             throw std::runtime_error("Failed to begin recording command buffer");
         }
 
-        // Begin the render pass
-        VkRenderPassBeginInfo renderPassInfo = {};
-        renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
-        renderPassInfo.renderPass = postProcessRenderPass;
-        renderPassInfo.framebuffer = resultImageFramebuffers[i];
-        renderPassInfo.renderArea.offset = { 0, 0 };
-        renderPassInfo.renderArea.extent = swapChain->GetVkExtent();
-
-        std::array<VkClearValue, 2> clearValues = {};
-        clearValues[0].color = { 0.0f, 0.0f, 0.0f, 1.0f };
-        clearValues[1].depthStencil = { 1.0f, 0 };
-        renderPassInfo.clearValueCount = static_cast<uint32_t>(clearValues.size());
-        renderPassInfo.pClearValues = clearValues.data();
-
-        // Bind the camera descriptor set. This is set 0 in all pipelines so it will be inherited
-        vkCmdBindDescriptorSets(postCommandBuffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, postProcessPipelineLayout, 0, 1, &colorDepthDescriptorSet, 0, nullptr);
+        uint32_t firstItem = std::min(t * itemsPerThread, itemCount);
+        uint32_t lastItem = std::min(firstItem + itemsPerThread, itemCount);
+        RecordSceneDraws(commandBuffer, firstItem, lastItem);
 
-        vkCmdBeginRenderPass(postCommandBuffers[i], &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+        if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS) {
+            throw std::runtime_error("Failed to record command buffer");
+        }
+    };
 
-        // Bind the graphics pipeline
-        vkCmdBindPipeline(postCommandBuffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, postProcessPipeline);
+    // The first chunk is recorded on this thread while the workers record the rest
+    std::vector<std::future<void>> workers;
+    for (uint32_t t = 1; t < recordingThreads; ++t) {
+        workers.push_back(std::async(std::launch::async, recordChunk, t));
+    }
+    recordChunk(0);
 
-        vkCmdPushConstants(postCommandBuffers[i], postProcessPipelineLayout, VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(Theme), &scene->theme);
+    VkCommandBuffer commandBuffer = frame.commandBuffer;
 
-        vkCmdDraw(postCommandBuffers[i], 3, 1, 0, 0);
+    VkCommandBufferBeginInfo beginInfo = {};
+    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    beginInfo.pInheritanceInfo = nullptr;
 
-        // End render pass
-        vkCmdEndRenderPass(postCommandBuffers[i]);
+    // ~ Start recording ~
+    if (vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS) {
+        throw std::runtime_error("Failed to begin recording command buffer");
+    }
 
-        // ~ End recording ~
-        if (vkEndCommandBuffer(postCommandBuffers[i]) != VK_SUCCESS) {
-            throw std::runtime_error("Failed to record command buffer");
+    std::vector<VkBufferMemoryBarrier> barriers(scene->GetBlades().size() + scene->GetReeds().size());
+    for (uint32_t j = 0; j < barriers.size(); ++j) {
+        barriers[j].sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+        barriers[j].srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+        barriers[j].dstAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT;
+        barriers[j].srcQueueFamilyIndex = device->GetQueueIndex(QueueFlags::Compute);
+        barriers[j].dstQueueFamilyIndex = device->GetQueueIndex(QueueFlags::Graphics);
+        barriers[j].offset = 0;
+        if (j < scene->GetBlades().size()) {
+            barriers[j].buffer = scene->GetBlades()[j]->GetNumBladesBuffer();
+            barriers[j].size = VK_WHOLE_SIZE;
+        }
+        else {
+            barriers[j].buffer = scene->GetReeds()[j - scene->GetBlades().size()]->GetNumReedsBuffer();
+            barriers[j].size = VK_WHOLE_SIZE;
         }
     }
-}
 
-void Renderer::RecordCommandBuffers() {
-    commandBuffers.resize(swapChain->GetCount());
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT, 0, 0, nullptr, barriers.size(), barriers.data(), 0, nullptr);
 
-    // Specify the command pool and number of buffers to allocate
-    VkCommandBufferAllocateInfo allocInfo = {};
-    allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
-    allocInfo.commandPool = graphicsCommandPool;
-    allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
-    allocInfo.commandBufferCount = static_cast<uint32_t>(commandBuffers.size());
+    // The compute queries are reset by the compute command buffer
+    if (timestampQueryPool != VK_NULL_HANDLE) {
+        vkCmdResetQueryPool(commandBuffer, timestampQueryPool, frame.firstQuery + TIMESTAMP_SCENE_BEGIN, TIMESTAMPS_PER_FRAME - TIMESTAMP_SCENE_BEGIN);
+        vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, timestampQueryPool, frame.firstQuery + TIMESTAMP_SCENE_BEGIN);
+    }
 
-    if (vkAllocateCommandBuffers(logicalDevice, &allocInfo, commandBuffers.data()) != VK_SUCCESS) {
-        throw std::runtime_error("Failed to allocate command buffers");
+    // Begin the render pass
+    VkRenderPassBeginInfo renderPassInfo = {};
+    renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+    renderPassInfo.renderPass = renderPass;
+    renderPassInfo.framebuffer = framebuffers[imageIndex];
+    renderPassInfo.renderArea.offset = { 0, 0 };
+    renderPassInfo.renderArea.extent = swapChain->GetVkExtent();
+
+    std::array<VkClearValue, 2> clearValues = {};
+    clearValues[0].color = { 0.5f, 0.5f, 0.5f, 0.0f };
+    clearValues[1].depthStencil = { 1.0f, 0 };
+    renderPassInfo.clearValueCount = static_cast<uint32_t>(clearValues.size());
+    renderPassInfo.pClearValues = clearValues.data();
+
+    vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+
+    // Wait for the workers, get() rethrows anything they threw
+    for (std::future<void>& worker : workers) {
+        worker.get();
     }
+    vkCmdExecuteCommands(commandBuffer, static_cast<uint32_t>(frame.workerCommandBuffers.size()), frame.workerCommandBuffers.data());
 
-    // Start command buffer recording
-    for (size_t i = 0; i < commandBuffers.size(); i++) {
-        VkCommandBufferBeginInfo beginInfo = {};
-        beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
-        beginInfo.flags = VK_COMMAND_BUFFER_USAGE_SIMULTANEOUS_USE_BIT;
-        beginInfo.pInheritanceInfo = nullptr;
+    // End render pass
+    vkCmdEndRenderPass(commandBuffer);
 
-        // ~ Start recording ~
-        if (vkBeginCommandBuffer(commandBuffers[i], &beginInfo) != VK_SUCCESS) {
-            throw std::runtime_error("Failed to begin recording command buffer");
-        }
+    if (timestampQueryPool != VK_NULL_HANDLE) {
+        vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, timestampQueryPool, frame.firstQuery + TIMESTAMP_SCENE_END);
+    }
 
-        // Begin the render pass
-        VkRenderPassBeginInfo renderPassInfo = {};
-        renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
-        renderPassInfo.renderPass = renderPass;
-        renderPassInfo.framebuffer = framebuffers[i];
-        renderPassInfo.renderArea.offset = { 0, 0 };
-        renderPassInfo.renderArea.extent = swapChain->GetVkExtent();
-
-        std::array<VkClearValue, 2> clearValues = {};
-        clearValues[0].color = { 0.0f, 0.0f, 0.0f, 1.0f };
-        clearValues[1].depthStencil = { 1.0f, 0 };
-        renderPassInfo.clearValueCount = static_cast<uint32_t>(clearValues.size());
-        renderPassInfo.pClearValues = clearValues.data();
-
-        std::vector<VkBufferMemoryBarrier> barriers(scene->GetBlades().size());
-        for (uint32_t j = 0; j < barriers.size(); ++j) {
-            barriers[j].sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
-            barriers[j].srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
-            barriers[j].dstAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT;
-            barriers[j].srcQueueFamilyIndex = device->GetQueueIndex(QueueFlags::Compute);
-            barriers[j].dstQueueFamilyIndex = device->GetQueueIndex(QueueFlags::Graphics);
-            barriers[j].buffer = scene->GetBlades()[j]->GetNumBladesBuffer();
-            barriers[j].offset = 0;
-            barriers[j].size = sizeof(BladeDrawIndirect);
-        }
+    // Begin the post process render pass
+    VkRenderPassBeginInfo postRenderPassInfo = {};
+    postRenderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+    postRenderPassInfo.renderPass = postProcessRenderPass;
+    postRenderPassInfo.framebuffer = resultImageFramebuffers[imageIndex];
+    postRenderPassInfo.renderArea.offset = { 0, 0 };
+    postRenderPassInfo.renderArea.extent = swapChain->GetVkExtent();
 
-        vkCmdPipelineBarrier(commandBuffers[i], VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT, 0, 0, nullptr, barriers.size(), barriers.data(), 0, nullptr);
+    clearValues[0].color = { 0.0f, 0.0f, 0.0f, 0.0f };
+    postRenderPassInfo.clearValueCount = static_cast<uint32_t>(clearValues.size());
+    postRenderPassInfo.pClearValues = clearValues.data();
 
-        // Bind the camera descriptor set. This is set 0 in all pipelines so it will be inherited
-        vkCmdBindDescriptorSets(commandBuffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, graphicsPipelineLayout, 0, 1, &cameraDescriptorSet, 0, nullptr);
+    vkCmdBeginRenderPass(commandBuffer, &postRenderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
 
-        vkCmdBeginRenderPass(commandBuffers[i], &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+    // Bind the graphics pipeline
+    vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, postProcessPipeline);
+    vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, postProcessPipelineLayout, 0, 1, &cameraDescriptorSet, 0, nullptr);
+    vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, postProcessPipelineLayout, 1, 1, &colorDepthDescriptorSet, 0, nullptr);
+    vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, postProcessPipelineLayout, 2, 1, &timeDescriptorSet, 0, nullptr);
+    vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, postProcessPipelineLayout, 3, 1, &noiseMapDescriptorSet, 0, nullptr);
 
-        // Bind the graphics pipeline
-        vkCmdBindPipeline(commandBuffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, graphicsPipeline);
+    vkCmdDraw(commandBuffer, 3, 1, 0, 0);
 
-        for (uint32_t j = 0; j < scene->GetModels().size(); ++j) {
-            // Bind the vertex and index buffers
-            VkBuffer vertexBuffers[] = { scene->GetModels()[j]->getVertexBuffer() };
-            VkDeviceSize offsets[] = { 0 };
-            vkCmdBindVertexBuffers(commandBuffers[i], 0, 1, vertexBuffers, offsets);
+    // End render pass
+    vkCmdEndRenderPass(commandBuffer);
 
-            vkCmdBindIndexBuffer(commandBuffers[i], scene->GetModels()[j]->getIndexBuffer(), 0, VK_INDEX_TYPE_UINT32);
+    if (timestampQueryPool != VK_NULL_HANDLE) {
+        vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, timestampQueryPool, frame.firstQuery + TIMESTAMP_POST_PROCESS_END);
+    }
 
-            // Bind the descriptor set for each model
-            vkCmdBindDescriptorSets(commandBuffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, graphicsPipelineLayout, 1, 1, &modelDescriptorSets[j], 0, nullptr);
+    // ~ End recording ~
+    if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS) {
+        throw std::runtime_error("Failed to record command buffer");
+    }
+}
 
-            // Draw
-            std::vector<uint32_t> indices = scene->GetModels()[j]->getIndices();
-            vkCmdDrawIndexed(commandBuffers[i], static_cast<uint32_t>(indices.size()), 1, 0, 0, 0);
+void Renderer::WarmStart(uint32_t steps, float stepSize) {
+    // Blades start upright, so step the simulation until they have settled under gravity and wind.
+    // The wind is held at time zero so they settle where the first frame picks them up
+    vkDeviceWaitIdle(logicalDevice);
+    const Time frameTime = scene->time;
+    for (uint32_t i = 0; i < steps; ++i) {
+        // Default band distances, so every blade takes every step
+        Time stepTime;
+        stepTime.deltaTime = stepSize;
+        stepTime.bandDeltaTime = glm::vec4(stepSize);
+        scene->SetTime(stepTime);
+
+        // The time uniform is rewritten between steps, so each one has to finish before the next
+        VkSubmitInfo submitInfo = {};
+        submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+        submitInfo.commandBufferCount = 1;
+        submitInfo.pCommandBuffers = &frames[0].computeCommandBuffer;
+        if (vkQueueSubmit(device->GetQueue(QueueFlags::Compute), 1, &submitInfo, VK_NULL_HANDLE) != VK_SUCCESS) {
+            throw std::runtime_error("Failed to submit warm start command buffer");
         }
+        vkQueueWaitIdle(device->GetQueue(QueueFlags::Compute));
+    }
+    scene->SetTime(frameTime);
+}
 
-        // Bind the grass pipeline
-        vkCmdBindPipeline(commandBuffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, grassPipeline);
+void Renderer::ReadFrameResults(FrameContext& frame) {
+    if (!frame.resultsPending) return;
+    frame.resultsPending = false;
 
-        for (uint32_t j = 0; j < scene->GetBlades().size(); ++j) {
-            VkBuffer vertexBuffers[] = { scene->GetBlades()[j]->GetCulledBladesBuffer() };
-            VkDeviceSize offsets[] = { 0 };
-            vkCmdBindVertexBuffers(commandBuffers[i], 0, 1, vertexBuffers, offsets);
+    timingTotals.integratedBlades += mappedSimulationStats[frame.statsSlot];
+    ++timingTotals.statsFrames;
 
-            vkCmdBindDescriptorSets(commandBuffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, grassPipelineLayout, 1, 1, &grassDescriptorSets[j], 0, nullptr);
+    if (timestampQueryPool == VK_NULL_HANDLE) return;
 
-            // Draw
-            vkCmdDrawIndirect(commandBuffers[i], scene->GetBlades()[j]->GetNumBladesBuffer(), 0, 1, sizeof(BladeDrawIndirect));
-        }
+    // The compute submission has no fence of its own, a frame whose queries aren't all written yet is skipped
+    uint64_t timestamps[TIMESTAMPS_PER_FRAME];
+    if (vkGetQueryPoolResults(logicalDevice, timestampQueryPool, frame.firstQuery, TIMESTAMPS_PER_FRAME, sizeof(timestamps), timestamps, sizeof(uint64_t), VK_QUERY_RESULT_64_BIT) != VK_SUCCESS) {
+        return;
+    }
 
-        // End render pass
-        vkCmdEndRenderPass(commandBuffers[i]);
+    auto elapsedMs = [&](TimestampQuery begin, TimestampQuery end) {
+        return static_cast<double>(timestamps[end] - timestamps[begin]) * timestampPeriod * 1e-6;
+    };
+    timingTotals.computeMs += elapsedMs(TIMESTAMP_COMPUTE_BEGIN, TIMESTAMP_COMPUTE_END);
+    timingTotals.sceneMs += elapsedMs(TIMESTAMP_SCENE_BEGIN, TIMESTAMP_SCENE_END);
+    timingTotals.postProcessMs += elapsedMs(TIMESTAMP_SCENE_END, TIMESTAMP_POST_PROCESS_END);
+    ++timingTotals.gpuFrames;
+}
 
-        // ~ End recording ~
-        if (vkEndCommandBuffer(commandBuffers[i]) != VK_SUCCESS) {
-            throw std::runtime_error("Failed to record command buffer");
-        }
+void Renderer::ResetFrameTimings() {
+    timingTotals = FrameTimings();
+}
+
+FrameTimings Renderer::GetFrameTimings() const {
+    FrameTimings timings = timingTotals;
+    if (timings.gpuFrames > 0) {
+        timings.computeMs /= timings.gpuFrames;
+        timings.sceneMs /= timings.gpuFrames;
+        timings.postProcessMs /= timings.gpuFrames;
+    }
+    if (timings.cpuFrames > 0) {
+        timings.waitMs /= timings.cpuFrames;
+        timings.recordMs /= timings.cpuFrames;
+    }
+    if (timings.statsFrames > 0) {
+        timings.integratedBlades /= timings.statsFrames;
     }
+    return timings;
 }
 
 void Renderer::Frame() {
+    typedef std::chrono::high_resolution_clock Clock;
+    FrameContext& frame = frames[currentFrame];
+
+    // Wait until the GPU has finished with this frame's command buffers before recording into them again
+    Clock::time_point waitStart = Clock::now();
+    vkWaitForFences(logicalDevice, 1, &frame.inFlightFence, VK_TRUE, std::numeric_limits<uint64_t>::max());
+    std::chrono::duration<double, std::milli> waitTime = Clock::now() - waitStart;
+    ReadFrameResults(frame);
 
     VkSubmitInfo computeSubmitInfo = {};
     computeSubmitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
 
     computeSubmitInfo.commandBufferCount = 1;
-    computeSubmitInfo.pCommandBuffers = &computeCommandBuffer;
+    computeSubmitInfo.pCommandBuffers = &frame.computeCommandBuffer;
 
     if (vkQueueSubmit(device->GetQueue(QueueFlags::Compute), 1, &computeSubmitInfo, VK_NULL_HANDLE) != VK_SUCCESS) {
         throw std::runtime_error("Failed to submit draw command buffer");
@@ -2409,6 +3094,12 @@ void Renderer::Frame() {
         return;
     }
 
+    // Only reset once we know this frame will be submitted, otherwise the next wait never returns
+    vkResetFences(logicalDevice, 1, &frame.inFlightFence);
+    Clock::time_point recordStart = Clock::now();
+    RecordFrameCommandBuffer(frame, swapChain->GetIndex());
+    std::chrono::duration<double, std::milli> recordTime = Clock::now() - recordStart;
+
     // Submit the command buffer
     VkSubmitInfo submitInfo = {};
     submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
@@ -2420,28 +3111,26 @@ void Renderer::Frame() {
     submitInfo.pWaitDstStageMask = waitStages;
 
     submitInfo.commandBufferCount = 1;
-    submitInfo.pCommandBuffers = &commandBuffers[swapChain->GetIndex()];
+    submitInfo.pCommandBuffers = &frame.commandBuffer;
 
     VkSemaphore signalSemaphores[] = { swapChain->GetRenderFinishedVkSemaphore() };
     submitInfo.signalSemaphoreCount = 1;
     submitInfo.pSignalSemaphores = signalSemaphores;
 
-    if (vkQueueSubmit(device->GetQueue(QueueFlags::Graphics), 1, &submitInfo, VK_NULL_HANDLE) != VK_SUCCESS) {
+    if (vkQueueSubmit(device->GetQueue(QueueFlags::Graphics), 1, &submitInfo, frame.inFlightFence) != VK_SUCCESS) {
         throw std::runtime_error("Failed to submit draw command buffer");
     }
+    frame.resultsPending = true;
+
+    timingTotals.waitMs += waitTime.count();
+    timingTotals.recordMs += recordTime.count();
+    ++timingTotals.cpuFrames;
+
+    currentFrame = (currentFrame + 1) % static_cast<uint32_t>(frames.size());
 
     if (!swapChain->Present()) {
         RecreateFrameResources();
     }
-
-    if (reRecord)
-    {
-		reRecord = false;
-		vkQueueWaitIdle(device->GetQueue(QueueFlags::Graphics));
-        vkFreeCommandBuffers(logicalDevice, graphicsCommandPool, static_cast<uint32_t>(commandBuffers.size()), commandBuffers.data());
-		RecordGrassCommandBuffer();
-		RecordComputeCommandBuffer();
-    }
 }
 
 Scene* Renderer::GetScene()
@@ -2452,14 +3141,27 @@ Scene* Renderer::GetScene()
 Renderer::~Renderer() {
     vkDeviceWaitIdle(logicalDevice);
 
+    SavePipelineCache();
+    vkDestroyPipelineCache(logicalDevice, pipelineCache, nullptr);
+
     // TODO: destroy any resources you created
 
-    vkFreeCommandBuffers(logicalDevice, graphicsCommandPool, static_cast<uint32_t>(commandBuffers.size()), commandBuffers.data());
-    vkFreeCommandBuffers(logicalDevice, computeCommandPool, 1, &computeCommandBuffer);
+    for (FrameContext& frame : frames) {
+        vkFreeCommandBuffers(logicalDevice, computeCommandPool, 1, &frame.computeCommandBuffer);
+    }
+    DestroyFrameContexts();
+    vkDestroyQueryPool(logicalDevice, timestampQueryPool, nullptr);
+    vkUnmapMemory(logicalDevice, simulationStatsBufferMemory);
+    vkDestroyBuffer(logicalDevice, simulationStatsBuffer, nullptr);
+    device->RecordFree(simulationStatsBufferMemory);
+    vkFreeMemory(logicalDevice, simulationStatsBufferMemory, nullptr);
     
     vkDestroyPipeline(logicalDevice, graphicsPipeline, nullptr);
     vkDestroyPipeline(logicalDevice, grassPipeline, nullptr);
     vkDestroyPipeline(logicalDevice, computePipeline, nullptr);
+    vkDestroyPipeline(logicalDevice, generatePipeline, nullptr);
+    vkDestroyPipeline(logicalDevice, windPipeline, nullptr);
+    vkDestroyPipeline(logicalDevice, colliderPipeline, nullptr);
     vkDestroyPipeline(logicalDevice, grassInstancedPipeline, nullptr);
 	vkDestroyPipeline(logicalDevice, reedInstancedPipeline, nullptr);
 	vkDestroyPipeline(logicalDevice, postProcessPipeline, nullptr);
@@ -2467,6 +3169,9 @@ Renderer::~Renderer() {
     vkDestroyPipelineLayout(logicalDevice, graphicsPipelineLayout, nullptr);
     vkDestroyPipelineLayout(logicalDevice, grassPipelineLayout, nullptr);
     vkDestroyPipelineLayout(logicalDevice, computePipelineLayout, nullptr);
+    vkDestroyPipelineLayout(logicalDevice, generatePipelineLayout, nullptr);
+    vkDestroyPipelineLayout(logicalDevice, windPipelineLayout, nullptr);
+    vkDestroyPipelineLayout(logicalDevice, colliderPipelineLayout, nullptr);
 	vkDestroyPipelineLayout(logicalDevice, grassInstancedPipelineLayout, nullptr);
 	vkDestroyPipelineLayout(logicalDevice, reedInstancedPipelineLayout, nullptr);
 	vkDestroyPipelineLayout(logicalDevice, postProcessPipelineLayout, nullptr);
@@ -2479,12 +3184,26 @@ Renderer::~Renderer() {
 	vkDestroyDescriptorSetLayout(logicalDevice, numBladesDescriptorSetLayout, nullptr);
     vkDestroyDescriptorSetLayout(logicalDevice, colorDepthDescriptorSetLayout, nullptr);
 	vkDestroyDescriptorSetLayout(logicalDevice, noiseMapDescriptorSetLayout, nullptr);
+    vkDestroyDescriptorSetLayout(logicalDevice, windFieldDescriptorSetLayout, nullptr);
 
     vkDestroyImageView(logicalDevice, noiseImageView, nullptr);
+	device->RecordFree(noiseImageMemory);
 	vkFreeMemory(logicalDevice, noiseImageMemory, nullptr);
 	vkDestroyImage(logicalDevice, noiseImage, nullptr);
 	vkDestroySampler(logicalDevice, noiseSampler, nullptr);
 
+    vkDestroyImageView(logicalDevice, windFieldImageView, nullptr);
+    device->RecordFree(windFieldImageMemory);
+    vkFreeMemory(logicalDevice, windFieldImageMemory, nullptr);
+    vkDestroyImage(logicalDevice, windFieldImage, nullptr);
+
+    vkDestroyBuffer(logicalDevice, colliderCellCountBuffer, nullptr);
+    device->RecordFree(colliderCellCountBufferMemory);
+    vkFreeMemory(logicalDevice, colliderCellCountBufferMemory, nullptr);
+    vkDestroyBuffer(logicalDevice, colliderCellBuffer, nullptr);
+    device->RecordFree(colliderCellBufferMemory);
+    vkFreeMemory(logicalDevice, colliderCellBufferMemory, nullptr);
+
 
     vkDestroyDescriptorPool(logicalDevice, descriptorPool, nullptr);
 
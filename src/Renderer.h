@@ -5,6 +5,44 @@
 #include "Scene.h"
 #include "Camera.h"
 
+#include <initializer_list>
+#include <vector>
+
+// Recording state of one frame in flight, reset and re-recorded every frame
+struct FrameContext {
+    VkCommandPool commandPool;
+    VkCommandBuffer commandBuffer;
+    // Pools are externally synchronized, so each recording thread has its own
+    std::vector<VkCommandPool> workerPools;
+    std::vector<VkCommandBuffer> workerCommandBuffers;
+    // Signaled when the GPU is done with this frame's command buffers
+    VkFence inFlightFence;
+    // Recorded once, reused whenever this frame context comes around
+    VkCommandBuffer computeCommandBuffer;
+    // This frame's range of the timestamp query pool and its simulation stats counter, read back after the fence
+    uint32_t firstQuery;
+    uint32_t statsSlot;
+    bool resultsPending = false;
+};
+
+// Per frame times in milliseconds, averaged over the frames since the last ResetFrameTimings
+struct FrameTimings {
+    // GPU passes, from timestamp queries
+    double computeMs = 0.0;
+    double sceneMs = 0.0;
+    double postProcessMs = 0.0;
+    uint32_t gpuFrames = 0;
+
+    // CPU time blocked on the frame fence and recording the frame command buffers
+    double waitMs = 0.0;
+    double recordMs = 0.0;
+    uint32_t cpuFrames = 0;
+
+    // Blades the simulation stepped, fewer than all when distance bands are set or blades sleep
+    double integratedBlades = 0.0;
+    uint32_t statsFrames = 0;
+};
+
 class Renderer {
 public:
     Renderer() = delete;
@@ -12,6 +50,13 @@ public:
     ~Renderer();
 
     void CreateCommandPools();
+    void ChooseWorkgroupSize();
+    void CreatePipelineCache();
+    void SavePipelineCache();
+    void CreateTimestampQueryPool();
+    void CreateSimulationStatsBuffer();
+    void CreateWindField();
+    void CreateColliderGrid();
 
     void CreateRenderPass();
 	void CreatePostProcessRenderPass();
@@ -22,6 +67,7 @@ public:
     void CreateComputeDescriptorSetLayout();
 	void CreateColorDepthDescriptorSetLayout();
 	void CreateNoiseMapDescriptorSetLayout();
+    void CreateWindFieldDescriptorSetLayout();
 
     void CreateDescriptorPool();
 
@@ -33,28 +79,39 @@ public:
     void CreateReedsComputeDescriptorSets();
 	void CreateColorDepthDescriptorSet();
 	void CreateNoiseMapDescriptorSet();
+    void CreateWindFieldDescriptorSet();
 
     void CreateGraphicsPipeline();
     void CreateGrassPipeline();
     void CreateComputePipeline();
+    void CreateGeneratePipeline();
+    void CreateWindPipeline();
+    void CreateColliderPipeline();
     void CreateGrassInstancedPipeline();
     void CreateReedInstancedPipeline();
 	void CreatePostProcessPipeline();
+    void CreatePipelinesParallel(std::initializer_list<void (Renderer::*)()> creators);
 
     void CreateFrameResources();
     void DestroyFrameResources();
     void RecreateFrameResources();
 
-    void RecordCommandBuffers();
-    void RecordComputeCommandBuffer();
-	void RecordGrassCommandBuffer();
-	void RecordPostProcessCommandBuffer();
+    void GenerateBlades();
+
+    void CreateFrameContexts();
+    void DestroyFrameContexts();
+
+    void RecordComputeCommandBuffers();
+    void RecordSceneDraws(VkCommandBuffer commandBuffer, uint32_t firstItem, uint32_t lastItem);
+    void RecordFrameCommandBuffer(FrameContext& frame, uint32_t imageIndex);
+    void ReadFrameResults(FrameContext& frame);
 
+    void WarmStart(uint32_t steps, float stepSize);
     void Frame();
 	Scene* GetScene();
-    bool reRecord = false;
-	bool renderGrass = true;
-	bool renderReeds = true;
+
+    void ResetFrameTimings();
+    FrameTimings GetFrameTimings() const;
 
 private:
     Device* device;
@@ -77,6 +134,7 @@ private:
 	VkDescriptorSetLayout numBladesDescriptorSetLayout;
 	VkDescriptorSetLayout colorDepthDescriptorSetLayout;
 	VkDescriptorSetLayout noiseMapDescriptorSetLayout;
+    VkDescriptorSetLayout windFieldDescriptorSetLayout;
     
     VkDescriptorPool descriptorPool;
 
@@ -92,10 +150,17 @@ private:
     std::vector<VkDescriptorSet> numReedsDescriptorSets;
     VkDescriptorSet colorDepthDescriptorSet;
 	VkDescriptorSet noiseMapDescriptorSet;
+    VkDescriptorSet windFieldDescriptorSet;
+
+    // Shared by every pipeline creation and persisted across runs
+    VkPipelineCache pipelineCache = VK_NULL_HANDLE;
 
     VkPipelineLayout graphicsPipelineLayout;
     VkPipelineLayout grassPipelineLayout;
     VkPipelineLayout computePipelineLayout;
+    VkPipelineLayout generatePipelineLayout;
+    VkPipelineLayout windPipelineLayout;
+    VkPipelineLayout colliderPipelineLayout;
 	VkPipelineLayout grassInstancedPipelineLayout;
 	VkPipelineLayout reedInstancedPipelineLayout;
 	VkPipelineLayout postProcessPipelineLayout;
@@ -103,6 +168,9 @@ private:
     VkPipeline graphicsPipeline;
     VkPipeline grassPipeline;
     VkPipeline computePipeline;
+    VkPipeline generatePipeline;
+    VkPipeline windPipeline;
+    VkPipeline colliderPipeline;
 	VkPipeline grassInstancedPipeline;
 	VkPipeline reedInstancedPipeline;
 	VkPipeline postProcessPipeline;
@@ -123,14 +191,37 @@ private:
 	VkImageView noiseImageView;
 	VkSampler noiseSampler;
 
+    // Wind forces rewritten every frame by the wind pass, sampled through the noise map set
+    VkImage windFieldImage;
+    VkDeviceMemory windFieldImageMemory;
+    VkImageView windFieldImageView;
+
+    // Scene colliders binned by cell every frame, a count per cell and a fixed number of slots after it
+    VkBuffer colliderCellCountBuffer;
+    VkDeviceMemory colliderCellCountBufferMemory;
+    VkBuffer colliderCellBuffer;
+    VkDeviceMemory colliderCellBufferMemory;
+
     VkSampler colorSampler;
 
 	VkSampleCountFlagBits msaaSamples = VK_SAMPLE_COUNT_4_BIT;
+    // local_size_x of the compute shaders, set through specialization constant 0
+    uint32_t workgroupSize = 32;
     std::vector<VkFramebuffer> framebuffers;
     std::vector<VkFramebuffer> resultImageFramebuffers;
 
-    std::vector<VkCommandBuffer> commandBuffers;
-    std::vector<VkCommandBuffer> postCommandBuffers;
-    VkCommandBuffer computeCommandBuffer;
+    std::vector<FrameContext> frames;
+    uint32_t currentFrame = 0;
+    uint32_t recordingThreads = 1;
+
+    // VK_NULL_HANDLE when the compute or graphics queue can't write timestamps
+    VkQueryPool timestampQueryPool = VK_NULL_HANDLE;
+    float timestampPeriod = 1.f;
+
+    // One counter per frame in flight, host visible so it is read without a copy
+    VkBuffer simulationStatsBuffer;
+    VkDeviceMemory simulationStatsBufferMemory;
+    const uint32_t* mappedSimulationStats = nullptr;
+    FrameTimings timingTotals;
 
 };
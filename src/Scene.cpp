@@ -1,10 +1,26 @@
 #include "Scene.h"
 #include "BufferUtils.h"
 
+#include <algorithm>
+
+namespace {
+    // The count is padded to the alignment of the collider array that follows it
+    const VkDeviceSize COLLIDERS_OFFSET = 16;
+    const VkDeviceSize COLLIDER_BUFFER_SIZE = COLLIDERS_OFFSET + MAX_COLLIDERS * sizeof(Collider);
+}
+
 Scene::Scene(Device* device) : device(device) {
     BufferUtils::CreateBuffer(device, sizeof(Time), VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, timeBuffer, timeBufferMemory);
     vkMapMemory(device->GetVkDevice(), timeBufferMemory, 0, sizeof(Time), 0, &mappedData);
     memcpy(mappedData, &time, sizeof(Time));
+
+    BufferUtils::CreateBuffer(device, sizeof(Theme), VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, themeBuffer, themeBufferMemory);
+    vkMapMemory(device->GetVkDevice(), themeBufferMemory, 0, sizeof(Theme), 0, &themeMappedData);
+    memcpy(themeMappedData, &theme, sizeof(Theme));
+
+    BufferUtils::CreateBuffer(device, COLLIDER_BUFFER_SIZE, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, colliderBuffer, colliderBufferMemory);
+    vkMapMemory(device->GetVkDevice(), colliderBufferMemory, 0, COLLIDER_BUFFER_SIZE, 0, &colliderMappedData);
+    UpdateColliders();
 }
 
 const std::vector<Model*>& Scene::GetModels() const {
@@ -41,9 +57,38 @@ void Scene::UpdateTime() {
     time.deltaTime = nextDeltaTime.count();
     time.totalTime += time.deltaTime;
 
+    ++time.frameIndex;
+    const uint32_t historySize = sizeof(recentDeltas) / sizeof(recentDeltas[0]);
+    recentDeltas[time.frameIndex % historySize] = time.deltaTime;
+    for (uint32_t b = 0; b < SIMULATION_BAND_COUNT; ++b) {
+        float sum = 0.0f;
+        for (uint32_t i = 0; i < (1u << b); ++i) {
+            sum += recentDeltas[(time.frameIndex - i) % historySize];
+        }
+        // Band 0 keeps the raw delta so nearby blades behave as before
+        time.bandDeltaTime[b] = b == 0 ? sum : std::min(sum, MAX_BAND_DELTA_TIME);
+    }
+
+    memcpy(mappedData, &time, sizeof(Time));
+}
+
+void Scene::SetTime(const Time& newTime) {
+    time = newTime;
     memcpy(mappedData, &time, sizeof(Time));
 }
 
+void Scene::UpdateTheme() {
+    memcpy(themeMappedData, &theme, sizeof(Theme));
+}
+
+void Scene::UpdateColliders() {
+    uint32_t count = static_cast<uint32_t>(std::min<size_t>(colliders.size(), MAX_COLLIDERS));
+    memcpy(colliderMappedData, &count, sizeof(count));
+    if (count > 0) {
+        memcpy(static_cast<char*>(colliderMappedData) + COLLIDERS_OFFSET, colliders.data(), count * sizeof(Collider));
+    }
+}
+
 void Scene::BeginTime()
 {
 	startTime = high_resolution_clock::now();
@@ -53,6 +98,14 @@ VkBuffer Scene::GetTimeBuffer() const {
     return timeBuffer;
 }
 
+VkBuffer Scene::GetThemeBuffer() const {
+    return themeBuffer;
+}
+
+VkBuffer Scene::GetColliderBuffer() const {
+    return colliderBuffer;
+}
+
 Scene::~Scene() {
 	for (auto ptr : models) {
 		delete ptr;
@@ -65,5 +118,14 @@ Scene::~Scene() {
 	}
     vkUnmapMemory(device->GetVkDevice(), timeBufferMemory);
     vkDestroyBuffer(device->GetVkDevice(), timeBuffer, nullptr);
+    device->RecordFree(timeBufferMemory);
     vkFreeMemory(device->GetVkDevice(), timeBufferMemory, nullptr);
+    vkUnmapMemory(device->GetVkDevice(), themeBufferMemory);
+    vkDestroyBuffer(device->GetVkDevice(), themeBuffer, nullptr);
+    device->RecordFree(themeBufferMemory);
+    vkFreeMemory(device->GetVkDevice(), themeBufferMemory, nullptr);
+    vkUnmapMemory(device->GetVkDevice(), colliderBufferMemory);
+    vkDestroyBuffer(device->GetVkDevice(), colliderBuffer, nullptr);
+    device->RecordFree(colliderBufferMemory);
+    vkFreeMemory(device->GetVkDevice(), colliderBufferMemory, nullptr);
 }
@@ -2,6 +2,8 @@
 
 #include <glm/glm.hpp>
 #include <chrono>
+#include <limits>
+#include <vector>
 
 #include "Model.h"
 #include "Blades.h"
@@ -9,11 +11,29 @@
 
 using namespace std::chrono;
 
+// Simulation distance bands, band b steps every 2^b frames
+constexpr static uint32_t SIMULATION_BAND_COUNT = 4;
+// Longest step a band may take, explicit steps get unstable past stiffness * step = 1
+constexpr static float MAX_BAND_DELTA_TIME = 0.2f;
+
+// Read by the shaders from a mapped uniform buffer, keep in sync with compute.comp
 struct Time {
     float deltaTime = 0.0f;
     float totalTime = 0.0f;
+    // Frames since startup, tiles of a band take turns stepping by it
+    uint32_t frameIndex = 0;
+    float pad = 0.0f;
+    // Time since a blade of band b last stepped, the sum of the last 2^b frame deltas
+    glm::vec4 bandDeltaTime = glm::vec4(0.0f);
+    // Camera distance where bands 1, 2 and 3 start, w is unused. Defaults keep every blade in band 0
+    glm::vec4 bandStart = glm::vec4(std::numeric_limits<float>::max());
 };
 
+// Bits of Theme::visibleMask, matched against SimulationParams::visibilityBit by the cull pass
+constexpr static uint32_t VISIBLE_GRASS = 1 << 0;
+constexpr static uint32_t VISIBLE_REEDS = 1 << 1;
+
+// Read by the shaders from a mapped uniform buffer, so edits only need UpdateTheme()
 struct Theme
 {
     glm::vec3 reedCol = glm::vec3(0.6, 0.64, 0.57);
@@ -24,6 +44,19 @@ struct Theme
     float ambientScale = 1.0f;
     glm::vec3 skyCol = glm::vec3(0.81, 0.665, 0.45) * 1.2f;
     float ambientBlend = 0.5f;
+    uint32_t visibleMask = VISIBLE_GRASS | VISIBLE_REEDS;
+    uint32_t pad2[3];
+};
+
+// Colliders uploaded per frame, the rest of a longer list is ignored
+constexpr static uint32_t MAX_COLLIDERS = 1024;
+
+// Capsule between a and b, a sphere when they are equal. Keep in sync with shaders/collider.glsl
+struct Collider {
+    glm::vec3 a;
+    float radius;
+    glm::vec3 b;
+    float pad = 0.0f;
 };
 
 class Scene {
@@ -35,15 +68,30 @@ private:
     
     void* mappedData;
 
+    VkBuffer themeBuffer;
+    VkDeviceMemory themeBufferMemory;
+
+    void* themeMappedData;
+
+    // Collider count followed by the colliders, read by the binning pass and the simulation
+    VkBuffer colliderBuffer;
+    VkDeviceMemory colliderBufferMemory;
+
+    void* colliderMappedData;
+
     std::vector<Model*> models;
     std::vector<Blades*> blades;
     std::vector<Reeds*> reeds;
 
 high_resolution_clock::time_point startTime = high_resolution_clock::now();
+    // Deltas of the last frames for the bands, recentDeltas[frameIndex % size] is the newest
+    float recentDeltas[1 << (SIMULATION_BAND_COUNT - 1)] = {};
 
 public:
     Time time;
 	Theme theme;
+    // Objects pushing grass and reeds aside, uploaded by UpdateColliders()
+    std::vector<Collider> colliders;
 
     Scene() = delete;
     Scene(Device* device);
@@ -58,7 +106,13 @@ public:
 	void AddReeds(Reeds* reeds);
 
     VkBuffer GetTimeBuffer() const;
+    VkBuffer GetThemeBuffer() const;
+    VkBuffer GetColliderBuffer() const;
 
     void UpdateTime();
+    // Fixed time for simulation steps outside the frame loop
+    void SetTime(const Time& newTime);
+    void UpdateTheme();
+    void UpdateColliders();
     void BeginTime();
 };
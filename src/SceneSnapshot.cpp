@@ -0,0 +1,137 @@
+#include "SceneSnapshot.h"
+#include "BufferUtils.h"
+#include "Scene.h"
+
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+namespace {
+    // FNV-1a, fed one field at a time so struct padding never reaches the hash
+    class ConfigHasher {
+    public:
+        template <typename T>
+        void Add(const T& value) {
+            const unsigned char* bytes = reinterpret_cast<const unsigned char*>(&value);
+            for (size_t i = 0; i < sizeof(T); i++) {
+                hash ^= bytes[i];
+                hash *= 1099511628211ull;
+            }
+        }
+
+        void AddShape(const BladeShape& shape) {
+            Add(shape.minHeight);
+            Add(shape.maxHeight);
+            Add(shape.minWidth);
+            Add(shape.maxWidth);
+            Add(shape.minBend);
+            Add(shape.maxBend);
+        }
+
+        uint64_t hash = 14695981039346656037ull;
+    };
+}
+
+uint64_t SceneSnapshot::HashConfig(const SceneConfig& config) {
+    ConfigHasher hasher;
+    hasher.Add(config.terrainWidth);
+    hasher.Add(config.terrainDepth);
+    hasher.Add(config.planeDim);
+    hasher.Add(config.reedScale);
+    hasher.Add(config.grass.bladesPerTile);
+    hasher.Add(static_cast<uint8_t>(config.grass.useClump));
+    hasher.AddShape(config.grass.shape);
+    hasher.Add(config.reeds.reedsPerSide);
+    hasher.Add(static_cast<uint8_t>(config.reeds.uniformSpawn));
+    hasher.AddShape(config.reeds.shape);
+    return hasher.hash;
+}
+
+bool SceneSnapshot::Open(const std::string& path, uint64_t configHash) {
+    Close();
+    if (!file.Open(path) || file.GetSize() < sizeof(SceneSnapshotHeader)) {
+        file.Close();
+        return false;
+    }
+
+    const SceneSnapshotHeader* mapped = static_cast<const SceneSnapshotHeader*>(file.GetData());
+    if (mapped->magic != SCENE_SNAPSHOT_MAGIC || mapped->version != SCENE_SNAPSHOT_VERSION || mapped->configHash != configHash ||
+        mapped->staticStride != sizeof(BladeStatic) || mapped->dynamicStride != sizeof(BladeDynamic)) {
+        file.Close();
+        return false;
+    }
+
+    // Every blob must lie inside the file
+    const uint64_t size = file.GetSize();
+    if (mapped->grassStaticOffset + uint64_t(mapped->grassCount) * sizeof(BladeStatic) > size ||
+        mapped->grassDynamicOffset + uint64_t(mapped->grassCount) * sizeof(BladeDynamic) > size ||
+        mapped->reedStaticOffset + uint64_t(mapped->reedCount) * sizeof(BladeStatic) > size ||
+        mapped->reedDynamicOffset + uint64_t(mapped->reedCount) * sizeof(BladeDynamic) > size) {
+        file.Close();
+        return false;
+    }
+
+    header = mapped;
+    return true;
+}
+
+void SceneSnapshot::Close() {
+    file.Close();
+    header = nullptr;
+}
+
+void SceneSnapshot::Write(Device* device, VkCommandPool commandPool, Scene* scene, const std::string& path, uint64_t configHash, bool settled) {
+    // Nothing may still be writing the blade buffers
+    vkDeviceWaitIdle(device->GetVkDevice());
+
+    std::vector<BladeStatic> grassStatic;
+    std::vector<BladeDynamic> grassDynamic;
+    for (const Blades* blades : scene->GetBlades()) {
+        size_t first = grassStatic.size();
+        size_t count = size_t(blades->GetTileCount()) * blades->GetBladesPerTile();
+        grassStatic.resize(first + count);
+        grassDynamic.resize(first + count);
+        BufferUtils::ReadBuffer(device, commandPool, blades->GetBladesStaticBuffer(), &grassStatic[first], count * sizeof(BladeStatic));
+        BufferUtils::ReadBuffer(device, commandPool, blades->GetBladesDynamicBuffer(), &grassDynamic[first], count * sizeof(BladeDynamic));
+    }
+
+    std::vector<BladeStatic> reedStatic;
+    std::vector<BladeDynamic> reedDynamic;
+    uint32_t reedsSpawned = 0;
+    for (const Reeds* reeds : scene->GetReeds()) {
+        size_t first = reedStatic.size();
+        size_t count = size_t(reeds->GetTileCount()) * reeds->GetReedsPerTile();
+        reedStatic.resize(first + count);
+        reedDynamic.resize(first + count);
+        BufferUtils::ReadBuffer(device, commandPool, reeds->GetReedsStaticBuffer(), &reedStatic[first], count * sizeof(BladeStatic));
+        BufferUtils::ReadBuffer(device, commandPool, reeds->GetReedsDynamicBuffer(), &reedDynamic[first], count * sizeof(BladeDynamic));
+        reedsSpawned += reeds->reedsCount;
+    }
+
+    SceneSnapshotHeader header = {};
+    header.magic = SCENE_SNAPSHOT_MAGIC;
+    header.version = SCENE_SNAPSHOT_VERSION;
+    header.configHash = configHash;
+    header.staticStride = sizeof(BladeStatic);
+    header.dynamicStride = sizeof(BladeDynamic);
+    header.settled = settled ? 1 : 0;
+    header.reedsSpawned = reedsSpawned;
+    header.grassCount = static_cast<uint32_t>(grassStatic.size());
+    header.reedCount = static_cast<uint32_t>(reedStatic.size());
+    header.grassStaticOffset = sizeof(SceneSnapshotHeader);
+    header.grassDynamicOffset = header.grassStaticOffset + grassStatic.size() * sizeof(BladeStatic);
+    header.reedStaticOffset = header.grassDynamicOffset + grassDynamic.size() * sizeof(BladeDynamic);
+    header.reedDynamicOffset = header.reedStaticOffset + reedStatic.size() * sizeof(BladeStatic);
+
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.write(reinterpret_cast<const char*>(grassStatic.data()), grassStatic.size() * sizeof(BladeStatic));
+    out.write(reinterpret_cast<const char*>(grassDynamic.data()), grassDynamic.size() * sizeof(BladeDynamic));
+    out.write(reinterpret_cast<const char*>(reedStatic.data()), reedStatic.size() * sizeof(BladeStatic));
+    out.write(reinterpret_cast<const char*>(reedDynamic.data()), reedDynamic.size() * sizeof(BladeDynamic));
+    if (!out) {
+        std::cout << "Failed to write scene snapshot " << path << std::endl;
+        return;
+    }
+    std::cout << "Wrote scene snapshot " << path << std::endl;
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <string>
+#include <vulkan/vulkan.h>
+
+#include "BladePacking.h"
+#include "MappedFile.h"
+#include "SceneConfig.h"
+
+class Device;
+class Scene;
+
+// "GSNP", bump the version whenever BladeStatic, BladeDynamic or blade generation changes
+constexpr static uint32_t SCENE_SNAPSHOT_MAGIC = 0x504e5347;
+constexpr static uint32_t SCENE_SNAPSHOT_VERSION = 1;
+
+struct SceneSnapshotHeader {
+    uint32_t magic;
+    uint32_t version;
+    // SceneSnapshot::HashConfig of the settings the blades were generated from
+    uint64_t configHash;
+    uint32_t staticStride;
+    uint32_t dynamicStride;
+    // Set when the dynamic arrays hold simulated state rather than freshly generated blades
+    uint32_t settled;
+    // Spawned reeds, the reed arrays also hold the empty slots of each tile
+    uint32_t reedsSpawned;
+    uint32_t grassCount;
+    uint32_t reedCount;
+    // Blobs follow the header, offsets are in bytes from the start of the file
+    uint64_t grassStaticOffset;
+    uint64_t grassDynamicOffset;
+    uint64_t reedStaticOffset;
+    uint64_t reedDynamicOffset;
+};
+
+static_assert(sizeof(SceneSnapshotHeader) == 72, "SceneSnapshotHeader is written to disk as is");
+
+// Generated grass and reed arrays saved after a first run and mapped on the next, so large
+// worlds skip generation and come up bit-identical. Arrays are staged straight from the mapping
+class SceneSnapshot {
+private:
+    MappedFile file;
+    const SceneSnapshotHeader* header = nullptr;
+
+    template <typename T>
+    const T* Blob(uint64_t offset) const {
+        return reinterpret_cast<const T*>(static_cast<const char*>(file.GetData()) + offset);
+    }
+
+public:
+    // Covers every setting that changes what is generated, a snapshot only loads for the same hash
+    static uint64_t HashConfig(const SceneConfig& config);
+
+    // False when the file is missing, stale or from a different config
+    bool Open(const std::string& path, uint64_t configHash);
+    void Close();
+    bool IsOpen() const { return header != nullptr; }
+    bool IsSettled() const { return header->settled != 0; }
+
+    uint32_t GetGrassCount() const { return header->grassCount; }
+    const BladeStatic* GetGrassStatic() const { return Blob<BladeStatic>(header->grassStaticOffset); }
+    const BladeDynamic* GetGrassDynamic() const { return Blob<BladeDynamic>(header->grassDynamicOffset); }
+
+    uint32_t GetReedCount() const { return header->reedCount; }
+    uint32_t GetReedsSpawned() const { return header->reedsSpawned; }
+    const BladeStatic* GetReedStatic() const { return Blob<BladeStatic>(header->reedStaticOffset); }
+    const BladeDynamic* GetReedDynamic() const { return Blob<BladeDynamic>(header->reedDynamicOffset); }
+
+    // Read the scene's blade buffers back and write them to path. With settled set the
+    // current simulation state is kept, otherwise the scene should not have been simulated yet
+    static void Write(Device* device, VkCommandPool commandPool, Scene* scene, const std::string& path, uint64_t configHash, bool settled);
+};
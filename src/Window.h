@@ -13,6 +13,7 @@
 struct GLFWwindow;
 struct GLFWwindow* GetGLFWWindow();
 
-void InitializeWindow(int width, int height, const char* name);
+// An invisible window still gets a swap chain, used for unattended benchmark runs
+void InitializeWindow(int width, int height, const char* name, bool visible = true);
 bool ShouldQuit();
 void DestroyWindow();
@@ -0,0 +1,250 @@
+// CPU microbenchmarks, no GPU needed. Prints one JSON document to stdout.
+//   grass_bench [--filter=substring] [--min_time=seconds] [--obj=path] [--tiles=count]
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "BladeGeneration.h"
+#include "GrassSimulation.h"
+#include "MeshUtils.h"
+#include "Terrain.h"
+
+namespace {
+    // Default scene settings, same as the renderer without a config
+    const GrassSettings grassSettings;
+    const ReedSettings reedSettings;
+    const uint32_t BLADES_PER_TILE = grassSettings.bladesPerTile;
+    const float PLANE_DIM = 50.f;
+
+    struct Options {
+        std::string filter;
+        double minTime = 0.5;
+        std::string objFile = "images/reed.obj";
+        uint32_t tiles = 64;
+    };
+
+    struct Result {
+        std::string name;
+        std::string itemName;
+        uint64_t iterations;
+        double nsPerOp;
+        double itemsPerSecond;
+    };
+
+    // Keeps results alive so the timed work isn't optimised away
+    volatile float sink;
+
+    // Run op in doubling batches until minTime has passed. op returns how many items it processed
+    Result Run(const Options& options, const std::string& name, const std::string& itemName, const std::function<double()>& op) {
+        typedef std::chrono::high_resolution_clock Clock;
+
+        // Warm up caches and lazily built state
+        op();
+
+        uint64_t iterations = 0;
+        uint64_t batch = 1;
+        double items = 0.0;
+        double elapsed = 0.0;
+        while (elapsed < options.minTime) {
+            Clock::time_point start = Clock::now();
+            for (uint64_t i = 0; i < batch; ++i) {
+                items += op();
+            }
+            elapsed += std::chrono::duration<double>(Clock::now() - start).count();
+            iterations += batch;
+            batch *= 2;
+        }
+
+        Result result;
+        result.name = name;
+        result.itemName = itemName;
+        result.iterations = iterations;
+        result.nsPerOp = elapsed * 1e9 / iterations;
+        result.itemsPerSecond = items / elapsed;
+        return result;
+    }
+
+    Options ParseOptions(int argc, char** argv) {
+        Options options;
+        for (int i = 1; i < argc; ++i) {
+            std::string arg = argv[i];
+            size_t equals = arg.find('=');
+            std::string key = arg.substr(0, equals);
+            std::string value = equals == std::string::npos ? "" : arg.substr(equals + 1);
+            if (key == "--filter") options.filter = value;
+            else if (key == "--min_time") options.minTime = std::atof(value.c_str());
+            else if (key == "--obj") options.objFile = value;
+            else if (key == "--tiles") options.tiles = std::max(1, std::atoi(value.c_str()));
+            else throw std::runtime_error("Unknown option " + arg);
+        }
+        return options;
+    }
+
+    std::vector<glm::vec3> TileOffsets(uint32_t count) {
+        std::vector<glm::vec3> offsets;
+        uint32_t side = static_cast<uint32_t>(std::ceil(std::sqrt(static_cast<float>(count))));
+        for (uint32_t t = 0; t < count; ++t) {
+            offsets.push_back(glm::vec3((t % side) * PLANE_DIM, 0.f, (t / side) * PLANE_DIM));
+        }
+        return offsets;
+    }
+
+    GrassSimulation::NoiseField MakeNoise() {
+        std::vector<uint8_t> rgba(256 * 256 * 4);
+        for (uint8_t& texel : rgba) {
+            texel = static_cast<uint8_t>(rand() & 0xff);
+        }
+        return GrassSimulation::NoiseField(256, 256, rgba.data());
+    }
+
+    std::vector<GrassSimulation::BladeBatch> MakeTiles(const std::vector<glm::vec3>& offsets) {
+        std::vector<GrassSimulation::BladeBatch> tiles(offsets.size());
+        std::vector<BladeStatic> bladesStatic(BLADES_PER_TILE);
+        std::vector<BladeDynamic> bladesDynamic(BLADES_PER_TILE);
+        for (size_t t = 0; t < offsets.size(); ++t) {
+            BladeGeneration::GenerateGrassTile(offsets[t], PLANE_DIM, grassSettings, bladesStatic.data(), bladesDynamic.data());
+            tiles[t].Load(bladesStatic.data(), bladesDynamic.data(), BLADES_PER_TILE);
+        }
+        return tiles;
+    }
+}
+
+int main(int argc, char** argv) {
+    Options options;
+    try {
+        options = ParseOptions(argc, argv);
+    }
+    catch (const std::exception& e) {
+        std::fprintf(stderr, "%s\n", e.what());
+        return EXIT_FAILURE;
+    }
+
+    srand(1);
+    std::vector<Result> results;
+    auto add = [&](const std::string& name, const std::string& itemName, const std::function<double()>& op) {
+        if (name.find(options.filter) != std::string::npos) {
+            results.push_back(Run(options, name, itemName, op));
+        }
+    };
+
+    const std::vector<glm::vec3> offsets = TileOffsets(options.tiles);
+
+    // Samples spread over a few tiles so clump and noise lookups don't hit the same cells
+    std::vector<glm::vec2> samples(1024);
+    for (glm::vec2& sample : samples) {
+        sample = (glm::vec2(generateRandomFloat(), generateRandomFloat()) - 0.5f) * PLANE_DIM * 4.f;
+    }
+
+    // Scene construction
+    std::vector<BladeStatic> bladesStatic(BLADES_PER_TILE);
+    std::vector<BladeDynamic> bladesDynamic(BLADES_PER_TILE);
+    add("Blades/GenerateGrassTile", "blades", [&]() {
+        BladeGeneration::GenerateGrassTile(offsets[0], PLANE_DIM, grassSettings, bladesStatic.data(), bladesDynamic.data());
+        sink = bladesStatic[0].v0.x;
+        return double(BLADES_PER_TILE);
+    });
+
+    add("Terrain/getNearestClumpGrid", "samples", [&]() {
+        float sum = 0.f;
+        for (const glm::vec2& sample : samples) {
+            sum += getNearestClumpGrid(sample).z;
+        }
+        sink = sum;
+        return double(samples.size());
+    });
+
+    add("Terrain/terrainHeight", "samples", [&]() {
+        float sum = 0.f;
+        for (const glm::vec2& sample : samples) {
+            sum += terrainHeight(sample);
+        }
+        sink = sum;
+        return double(samples.size());
+    });
+
+    std::vector<BladeStatic> reedsStatic(reedSettings.ReedsPerTile());
+    std::vector<BladeDynamic> reedsDynamic(reedSettings.ReedsPerTile());
+    add("Reeds/GenerateReedTile", "blades", [&]() {
+        uint32_t reedCount = BladeGeneration::GenerateReedTile(offsets[0], PLANE_DIM, reedSettings, reedsStatic.data(), reedsDynamic.data());
+        sink = reedsStatic[0].v0.x;
+        return double(reedCount);
+    });
+
+    // The OBJ is optional, the benchmark is skipped when it can't be read
+    std::vector<MeshCorner> corners;
+    try {
+        MeshUtils::LoadReedCorners(options.objFile, corners);
+    }
+    catch (const std::exception&) {
+        std::fprintf(stderr, "Skipping mesh benchmarks, could not load %s\n", options.objFile.c_str());
+    }
+    if (!corners.empty()) {
+        add("Mesh/LoadReedCorners", "corners", [&]() {
+            std::vector<MeshCorner> loaded;
+            MeshUtils::LoadReedCorners(options.objFile, loaded);
+            return double(loaded.size());
+        });
+
+        add("Mesh/WeldVertices", "corners", [&]() {
+            std::vector<ReedVertex> vertices;
+            std::vector<uint32_t> indices;
+            MeshUtils::WeldVertices(corners, vertices, indices);
+            sink = float(vertices.size());
+            return double(corners.size());
+        });
+    }
+
+    // Simulation step
+    const GrassSimulation::WindParams wind;
+    const GrassSimulation::NoiseField noise = MakeNoise();
+    std::vector<GrassSimulation::BladeBatch> tiles = MakeTiles(offsets);
+    float totalTime = 0.f;
+
+    add("Simulation/SimulateScalar", "blades", [&]() {
+        GrassSimulation::SimulateScalar(tiles[0], 0, tiles[0].Size(), wind, noise, 0.016f, totalTime += 0.016f);
+        return double(tiles[0].Size());
+    });
+
+    add("Simulation/Simulate", "blades", [&]() {
+        GrassSimulation::Simulate(tiles[0], wind, noise, 0.016f, totalTime += 0.016f);
+        return double(tiles[0].Size());
+    });
+
+    add("Simulation/SimulateTiles", "blades", [&]() {
+        GrassSimulation::SimulateTiles(tiles, wind, noise, 0.016f, totalTime += 0.016f);
+        return double(tiles.size() * BLADES_PER_TILE);
+    });
+
+    // Same layout as Google Benchmark's JSON reporter, with ns_per_op and blades_per_second added
+    std::printf("{\n  \"context\": {\n");
+    std::printf("    \"num_cpus\": %u,\n", std::thread::hardware_concurrency());
+    std::printf("    \"tiles\": %u,\n", options.tiles);
+    std::printf("    \"blades_per_tile\": %u\n", BLADES_PER_TILE);
+    std::printf("  },\n  \"benchmarks\": [\n");
+    for (size_t i = 0; i < results.size(); ++i) {
+        const Result& result = results[i];
+        std::printf("    {\n");
+        std::printf("      \"name\": \"%s\",\n", result.name.c_str());
+        std::printf("      \"iterations\": %llu,\n", static_cast<unsigned long long>(result.iterations));
+        std::printf("      \"real_time\": %.3f,\n", result.nsPerOp);
+        std::printf("      \"time_unit\": \"ns\",\n");
+        std::printf("      \"ns_per_op\": %.3f,\n", result.nsPerOp);
+        if (result.itemName == "blades") {
+            std::printf("      \"blades_per_second\": %.1f,\n", result.itemsPerSecond);
+        }
+        std::printf("      \"items_per_second\": %.1f,\n", result.itemsPerSecond);
+        std::printf("      \"item\": \"%s\"\n", result.itemName.c_str());
+        std::printf("    }%s\n", i + 1 < results.size() ? "," : "");
+    }
+    std::printf("  ]\n}\n");
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,124 @@
+#include "BladeGeneration.h"
+#include "ReedMesh.h"
+#include "Terrain.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <glm/gtc/noise.hpp>
+
+namespace BladeGeneration {
+    BladeAttributes GenerateGrassBlade(glm::vec3 offset, float planeDim, const GrassSettings& settings) {
+        const BladeShape& shape = settings.shape;
+        BladeAttributes currentBlade;
+
+        glm::vec3 bladeUp(0.0f, 1.0f, 0.0f);
+
+        // Generate positions and direction (v0)
+        float x = (generateRandomFloat() - 0.5f) * planeDim;
+        float y = 0.0f;
+        float z = (generateRandomFloat() - 0.5f) * planeDim;
+        float direction = generateRandomFloat() * 2.f * 3.14159265f;
+        glm::vec3 bladePosition(x, y, z);
+        bladePosition += offset;
+        glm::vec2 bladeXZPosition(bladePosition.x, bladePosition.z);
+        glm::vec4 clumpData = getNearestClumpGrid(bladeXZPosition);
+        float distToCenter = glm::distance(bladeXZPosition, glm::vec2(clumpData.z, clumpData.w));
+
+        if (settings.useClump) {
+            // shift to clump center a little bit
+            bladeXZPosition = glm::mix(bladeXZPosition, glm::vec2(clumpData.z, clumpData.w), 0.01f);
+            bladePosition.x = bladeXZPosition.x;
+            bladePosition.z = bladeXZPosition.y;
+            bladePosition.y += terrainHeight(bladeXZPosition);
+
+            // face to the same direction
+            float clumpDir = hash32(glm::vec3(clumpData.x, clumpData.y, 0.6f)).x * 2.f * 3.14159265f;
+            direction = glm::mix(direction, clumpDir, 0.6f);
+
+            // face off to center
+            float offCenterDir = std::atan2(bladePosition.z - clumpData.w, bladePosition.x - clumpData.z) + 0.5f * 3.14159265f;
+            direction = glm::mix(direction, offCenterDir, 0.4f);
+        }
+        currentBlade.v0 = bladePosition;
+        currentBlade.direction = direction;
+
+        // Bezier point and height (v1)
+        float height = shape.minHeight + (generateRandomFloat() * (shape.maxHeight - shape.minHeight)) + 6.f * glm::exp(-0.3f * distToCenter);
+        currentBlade.v1 = bladePosition + bladeUp * height;
+        currentBlade.height = height;
+
+        // Physical model guide and width (v2)
+        float width = shape.minWidth + (generateRandomFloat() * (shape.maxWidth - shape.minWidth));
+        currentBlade.v2 = bladePosition + bladeUp * height;
+        currentBlade.width = width;
+
+        // Stiffness coefficient, the up vector is always +Y
+        currentBlade.stiffness = shape.minBend + (generateRandomFloat() * (shape.maxBend - shape.minBend));
+        currentBlade.terrainNormal = terrainNormal(glm::vec2(bladePosition.x, bladePosition.z));
+        currentBlade.variant = 0;
+        return currentBlade;
+    }
+
+    void GenerateGrassTile(glm::vec3 offset, float planeDim, const GrassSettings& settings, BladeStatic* bladesStatic, BladeDynamic* bladesDynamic) {
+        for (uint32_t i = 0; i < settings.bladesPerTile; i++) {
+            BladeAttributes currentBlade = GenerateGrassBlade(offset, planeDim, settings);
+            bladesStatic[i] = BladePacking::PackStatic(currentBlade);
+            bladesDynamic[i] = BladePacking::PackDynamic(currentBlade);
+        }
+    }
+
+    uint32_t GenerateReedTile(glm::vec3 offset, float planeDim, const ReedSettings& settings, BladeStatic* reedsStatic, BladeDynamic* reedsDynamic) {
+        const BladeShape& shape = settings.shape;
+        const uint32_t side = settings.reedsPerSide;
+        float gridSize = planeDim / side;
+        uint32_t reedCount = 0;
+        for (uint32_t i = 0; i < side; i++) {
+            for (uint32_t j = 0; j < side; j++) {
+                glm::vec2 gridBase = -0.5f * glm::vec2(planeDim) + glm::vec2(i * gridSize, j * gridSize);
+                float spawnChance = settings.uniformSpawn ? 0.5f : (1.f - glm::perlin(0.02f * gridBase + 146.1413f) * 2.4f) * 0.5f;
+                float r = static_cast <float> (rand()) / static_cast <float> (RAND_MAX);
+                if (r > spawnChance) {
+                    continue;
+                }
+
+                BladeAttributes currentBlade;
+
+                glm::vec3 bladeUp = glm::normalize(glm::vec3(0.f, 1.0f, 0.f));
+
+                // Generate positions and direction (v0)
+                float x = generateRandomFloat() * gridSize + gridBase.x;
+                float z = generateRandomFloat() * gridSize + gridBase.y;
+                float y = 0.f;
+                float direction = generateRandomFloat() * 0.2f * 3.14159265f + 1.3f * 3.14159265f;
+                glm::vec3 bladePosition(x, y, z);
+                bladePosition += offset;
+                glm::vec2 bladeXZPosition(bladePosition.x, bladePosition.z);
+                bladePosition.y = terrainHeight(bladeXZPosition);
+
+                currentBlade.v0 = bladePosition;
+                currentBlade.direction = direction;
+
+                // Bezier point and height (v1)
+                float height = shape.minHeight + (generateRandomFloat() * (shape.maxHeight - shape.minHeight));
+                currentBlade.v1 = bladePosition + bladeUp * height;
+                currentBlade.height = height;
+
+                // Physical model guide and width (v2)
+                float width = shape.minWidth + (generateRandomFloat() * (shape.maxWidth - shape.minWidth));
+                currentBlade.v2 = bladePosition + bladeUp * height;
+                currentBlade.width = width;
+
+                // Stiffness coefficient, the up vector is always +Y
+                currentBlade.stiffness = shape.minBend + (generateRandomFloat() * (shape.maxBend - shape.minBend));
+                currentBlade.terrainNormal = terrainNormal(glm::vec2(bladePosition.x, bladePosition.z));
+                currentBlade.variant = std::min(static_cast<uint32_t>(generateRandomFloat() * REED_VARIANT_COUNT), REED_VARIANT_COUNT - 1);
+
+                reedsStatic[reedCount] = BladePacking::PackStatic(currentBlade);
+                reedsDynamic[reedCount] = BladePacking::PackDynamic(currentBlade);
+                reedCount++;
+            }
+        }
+        return reedCount;
+    }
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <cstdint>
+
+#include "BladePacking.h"
+
+// CPU blade and reed placement, the GPU path for grass is shaders/generate.comp
+
+// Ranges the per-blade attributes are drawn from
+struct BladeShape {
+    float minHeight;
+    float maxHeight;
+    float minWidth;
+    float maxWidth;
+    float minBend;
+    float maxBend;
+};
+
+struct GrassSettings {
+    uint32_t bladesPerTile = 1 << 8;
+    BladeShape shape = { 6.3f, 8.5f, 0.28f, 0.32f, 1.5f, 2.5f };
+    // Pull blades towards the nearest clump center and align them with it
+    bool useClump = true;
+};
+
+struct ReedSettings {
+    // Reeds spawn on a reedsPerSide x reedsPerSide grid per tile
+    uint32_t reedsPerSide = 1 << 6;
+    BladeShape shape = { 10.3f, 16.5f, 0.28f, 0.32f, 3.6f, 4.6f };
+    // Same spawn chance everywhere instead of perlin patches
+    bool uniformSpawn = false;
+
+    uint32_t ReedsPerTile() const { return reedsPerSide * reedsPerSide; }
+};
+
+namespace BladeGeneration {
+    // One grass blade somewhere on the tile centred at offset
+    BladeAttributes GenerateGrassBlade(glm::vec3 offset, float planeDim, const GrassSettings& settings);
+
+    // Fill settings.bladesPerTile grass blades of one tile
+    void GenerateGrassTile(glm::vec3 offset, float planeDim, const GrassSettings& settings, BladeStatic* bladesStatic, BladeDynamic* bladesDynamic);
+
+    // Spawn the reeds of one tile, at most settings.ReedsPerTile(). Returns how many were written
+    uint32_t GenerateReedTile(glm::vec3 offset, float planeDim, const ReedSettings& settings, BladeStatic* reedsStatic, BladeDynamic* reedsDynamic);
+}
@@ -0,0 +1,121 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <cstdint>
+
+// Keep in sync with shaders/blade.glsl
+
+// v1 and v2 are stored relative to v0 as snorm16, scaled by this range
+constexpr static float BLADE_OFFSET_RANGE = 32.0f;
+
+// Attributes that never change after generation, 32 bytes in std430
+struct BladeStatic {
+    // Root position
+    glm::vec3 v0;
+    // Direction and height (half2)
+    uint32_t dirHeight;
+    // Width and stiffness coefficient (half2)
+    uint32_t widthStiffness;
+    // Terrain normal at the root (octahedral, 2 x snorm16)
+    uint32_t terrainNormal;
+    // Mesh variant, always 0 for grass
+    uint32_t variant;
+    uint32_t padding;
+};
+
+// State written by the simulation every frame
+struct BladeDynamic {
+    // xyz: v1 - v0 and v2 - v0 (6 x snorm16), w: sleep state owned by compute.comp, 0 is awake
+    glm::uvec4 bezier;
+};
+
+// Culled lists store two 16-bit blade indices per uint, so a tile holds at most 65536 blades
+constexpr static uint32_t MAX_BLADES_PER_TILE = 1 << 16;
+
+static_assert(sizeof(BladeStatic) == 32, "BladeStatic must match the std430 layout in blade.glsl");
+static_assert(sizeof(BladeDynamic) == 16, "BladeDynamic must match the std430 layout in blade.glsl");
+
+// Full precision blade, only used on the CPU
+struct BladeAttributes {
+    glm::vec3 v0;
+    glm::vec3 v1;
+    glm::vec3 v2;
+    float direction;
+    float height;
+    float width;
+    float stiffness;
+    glm::vec3 terrainNormal;
+    uint32_t variant;
+};
+
+namespace BladePacking {
+    // Size in bytes of a culled index list for count blades
+    constexpr uint32_t CulledIndexListSize(uint32_t count) {
+        return ((count + 1) / 2) * sizeof(uint32_t);
+    }
+
+    inline glm::uvec3 PackBezier(glm::vec3 v0, glm::vec3 v1, glm::vec3 v2) {
+        glm::vec3 d1 = (v1 - v0) / BLADE_OFFSET_RANGE;
+        glm::vec3 d2 = (v2 - v0) / BLADE_OFFSET_RANGE;
+        return glm::uvec3(glm::packSnorm2x16(glm::vec2(d1.x, d1.y)),
+                          glm::packSnorm2x16(glm::vec2(d1.z, d2.x)),
+                          glm::packSnorm2x16(glm::vec2(d2.y, d2.z)));
+    }
+
+    inline void UnpackBezier(glm::uvec3 bezier, glm::vec3 v0, glm::vec3& v1, glm::vec3& v2) {
+        glm::vec2 a = glm::unpackSnorm2x16(bezier.x) * BLADE_OFFSET_RANGE;
+        glm::vec2 b = glm::unpackSnorm2x16(bezier.y) * BLADE_OFFSET_RANGE;
+        glm::vec2 c = glm::unpackSnorm2x16(bezier.z) * BLADE_OFFSET_RANGE;
+        v1 = v0 + glm::vec3(a.x, a.y, b.x);
+        v2 = v0 + glm::vec3(b.y, c.x, c.y);
+    }
+
+    inline uint32_t PackOctahedral(glm::vec3 n) {
+        n /= glm::abs(n.x) + glm::abs(n.y) + glm::abs(n.z);
+        glm::vec2 p(n.x, n.y);
+        if (n.z < 0.f) {
+            p = (1.f - glm::abs(glm::vec2(n.y, n.x))) * glm::vec2(n.x >= 0.f ? 1.f : -1.f, n.y >= 0.f ? 1.f : -1.f);
+        }
+        return glm::packSnorm2x16(p);
+    }
+
+    inline glm::vec3 UnpackOctahedral(uint32_t packed) {
+        glm::vec2 p = glm::unpackSnorm2x16(packed);
+        glm::vec3 n(p.x, p.y, 1.f - glm::abs(p.x) - glm::abs(p.y));
+        float t = glm::max(-n.z, 0.f);
+        n.x += n.x >= 0.f ? -t : t;
+        n.y += n.y >= 0.f ? -t : t;
+        return glm::normalize(n);
+    }
+
+    inline BladeStatic PackStatic(const BladeAttributes& blade) {
+        BladeStatic packed = {};
+        packed.v0 = blade.v0;
+        packed.dirHeight = glm::packHalf2x16(glm::vec2(blade.direction, blade.height));
+        packed.widthStiffness = glm::packHalf2x16(glm::vec2(blade.width, blade.stiffness));
+        packed.terrainNormal = PackOctahedral(blade.terrainNormal);
+        packed.variant = blade.variant;
+        return packed;
+    }
+
+    inline BladeDynamic PackDynamic(const BladeAttributes& blade) {
+        BladeDynamic packed = {};
+        packed.bezier = glm::uvec4(PackBezier(blade.v0, blade.v1, blade.v2), 0u);
+        return packed;
+    }
+
+    inline BladeAttributes Unpack(const BladeStatic& bladeStatic, const BladeDynamic& bladeDynamic) {
+        BladeAttributes blade;
+        blade.v0 = bladeStatic.v0;
+        UnpackBezier(glm::uvec3(bladeDynamic.bezier), bladeStatic.v0, blade.v1, blade.v2);
+        glm::vec2 dirHeight = glm::unpackHalf2x16(bladeStatic.dirHeight);
+        glm::vec2 widthStiffness = glm::unpackHalf2x16(bladeStatic.widthStiffness);
+        blade.direction = dirHeight.x;
+        blade.height = dirHeight.y;
+        blade.width = widthStiffness.x;
+        blade.stiffness = widthStiffness.y;
+        blade.terrainNormal = UnpackOctahedral(bladeStatic.terrainNormal);
+        blade.variant = bladeStatic.variant;
+        return blade;
+    }
+}
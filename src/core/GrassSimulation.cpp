@@ -0,0 +1,276 @@
+#include "GrassSimulation.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <thread>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define GRASS_SIMULATION_SSE 1
+#include <emmintrin.h>
+#else
+#define GRASS_SIMULATION_SSE 0
+#endif
+
+namespace {
+    const float PI = 3.14159265f;
+
+    float Fract(float x) {
+        return x - std::floor(x);
+    }
+
+    // Round trip through the snorm16 offsets the GPU stores every frame
+    float QuantizeOffset(float v, float v0) {
+        float d = glm::clamp((v - v0) / BLADE_OFFSET_RANGE, -1.f, 1.f);
+        return v0 + std::nearbyint(d * 32767.f) / 32767.f * BLADE_OFFSET_RANGE;
+    }
+
+    // Wind force before it is scaled by how much the blade faces it and how upright it is
+    glm::vec3 BaseWindForce(const GrassSimulation::WindParams& wind, const GrassSimulation::NoiseField& noise, float v0x, float v0z, float totalTime) {
+        glm::vec2 p = glm::vec2(v0x, v0z) * 0.04f + wind.windSpeed * totalTime;
+        glm::vec3 perlin = noise.Sample(glm::vec2(Fract(p.x * 0.01f), Fract(p.y * 0.01f)));
+        float windAngle = 2.f * (perlin.r - 0.4f) * wind.windAngleVariance * PI + 0.3f * PI;
+        glm::vec3 windForce = wind.windStrength * (perlin.g + 0.2f) * glm::normalize(glm::vec3(std::cos(windAngle), wind.windDown * (perlin.b * 1.5f), std::sin(windAngle)));
+        return windForce * (0.5f * perlin + 0.5f);
+    }
+
+#if GRASS_SIMULATION_SSE
+    __m128 Length(__m128 x, __m128 y, __m128 z) {
+        return _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)), _mm_mul_ps(z, z)));
+    }
+
+    __m128 Select(__m128 mask, __m128 a, __m128 b) {
+        return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+    }
+
+    __m128 QuantizeOffset(__m128 v, __m128 v0) {
+        const __m128 one = _mm_set1_ps(1.f);
+        __m128 d = _mm_mul_ps(_mm_sub_ps(v, v0), _mm_set1_ps(1.f / BLADE_OFFSET_RANGE));
+        d = _mm_min_ps(_mm_max_ps(d, _mm_sub_ps(_mm_setzero_ps(), one)), one);
+        __m128i q = _mm_cvtps_epi32(_mm_mul_ps(d, _mm_set1_ps(32767.f)));
+        return _mm_add_ps(v0, _mm_mul_ps(_mm_cvtepi32_ps(q), _mm_set1_ps(BLADE_OFFSET_RANGE / 32767.f)));
+    }
+#endif
+}
+
+namespace GrassSimulation {
+    WindParams WindParams::ForReeds() {
+        WindParams wind;
+        wind.windStrength *= 2.f;
+        wind.windAngleVariance *= 0.2f;
+        return wind;
+    }
+
+    NoiseField::NoiseField(uint32_t width, uint32_t height, const uint8_t* rgba)
+        : width(width), height(height), texels(width * height) {
+        for (size_t i = 0; i < texels.size(); ++i) {
+            texels[i] = glm::vec3(rgba[4 * i], rgba[4 * i + 1], rgba[4 * i + 2]) / 255.f;
+        }
+    }
+
+    glm::vec3 NoiseField::Sample(glm::vec2 uv) const {
+        if (texels.empty()) {
+            return glm::vec3(0.f);
+        }
+
+        float x = uv.x * width - 0.5f;
+        float y = uv.y * height - 0.5f;
+        float fx = std::floor(x);
+        float fy = std::floor(y);
+        float tx = x - fx;
+        float ty = y - fy;
+
+        // Wrap like VK_SAMPLER_ADDRESS_MODE_REPEAT
+        int w = static_cast<int>(width);
+        int h = static_cast<int>(height);
+        int x0 = ((static_cast<int>(fx) % w) + w) % w;
+        int y0 = ((static_cast<int>(fy) % h) + h) % h;
+        int x1 = (x0 + 1) % w;
+        int y1 = (y0 + 1) % h;
+
+        glm::vec3 top = glm::mix(texels[y0 * w + x0], texels[y0 * w + x1], tx);
+        glm::vec3 bottom = glm::mix(texels[y1 * w + x0], texels[y1 * w + x1], tx);
+        return glm::mix(top, bottom, ty);
+    }
+
+    void BladeBatch::Resize(size_t count) {
+        for (std::vector<float>* array : { &v0x, &v0y, &v0z, &v1x, &v1y, &v1z, &v2x, &v2y, &v2z, &height, &stiffness, &norx, &norz }) {
+            array->resize(count);
+        }
+    }
+
+    void BladeBatch::Load(const BladeStatic* bladesStatic, const BladeDynamic* bladesDynamic, size_t count) {
+        Resize(count);
+        for (size_t i = 0; i < count; ++i) {
+            BladeAttributes blade = BladePacking::Unpack(bladesStatic[i], bladesDynamic[i]);
+            glm::vec3 dir(std::cos(blade.direction), 0.f, std::sin(blade.direction));
+            glm::vec3 nor = glm::normalize(glm::cross(glm::vec3(0.f, 1.f, 0.f), dir));
+
+            v0x[i] = blade.v0.x; v0y[i] = blade.v0.y; v0z[i] = blade.v0.z;
+            v1x[i] = blade.v1.x; v1y[i] = blade.v1.y; v1z[i] = blade.v1.z;
+            v2x[i] = blade.v2.x; v2y[i] = blade.v2.y; v2z[i] = blade.v2.z;
+            height[i] = blade.height;
+            stiffness[i] = blade.stiffness;
+            norx[i] = nor.x;
+            norz[i] = nor.z;
+        }
+    }
+
+    void BladeBatch::Store(BladeDynamic* bladesDynamic) const {
+        for (size_t i = 0; i < Size(); ++i) {
+            glm::uvec3 bezier = BladePacking::PackBezier(glm::vec3(v0x[i], v0y[i], v0z[i]), glm::vec3(v1x[i], v1y[i], v1z[i]), glm::vec3(v2x[i], v2y[i], v2z[i]));
+            bladesDynamic[i].bezier = glm::uvec4(bezier, bladesDynamic[i].bezier.w);
+        }
+    }
+
+    void SimulateScalar(BladeBatch& batch, size_t first, size_t last, const WindParams& wind, const NoiseField& noise, float deltaTime, float totalTime) {
+        const glm::vec3 up(0.f, 1.f, 0.f);
+
+        for (size_t i = first; i < last; ++i) {
+            float height = batch.height[i];
+            // Unused slots of sparse tiles
+            if (height == 0.f) continue;
+
+            glm::vec3 v0(batch.v0x[i], batch.v0y[i], batch.v0z[i]);
+            glm::vec3 v2(batch.v2x[i], batch.v2y[i], batch.v2z[i]);
+            glm::vec3 nor(batch.norx[i], 0.f, batch.norz[i]);
+
+            // gravity
+            glm::vec3 gravity = glm::vec3(0.f, -wind.gravity, 0.f) + (0.25f * wind.gravity) * nor;
+
+            // recovery
+            glm::vec3 tip = v0 + up * height;
+            glm::vec3 recovery = (tip - v2) * batch.stiffness[i];
+
+            // wind
+            glm::vec3 windForce = BaseWindForce(wind, noise, v0.x, v0.z, totalTime);
+            float windDir = 1.f - std::abs(glm::dot(glm::normalize(windForce), glm::normalize(v2 - v0)));
+            float windFr = glm::dot(v2 - v0, up) / height;
+            windForce *= windDir * windFr;
+
+            // update
+            v2 += (gravity + recovery + windForce) * deltaTime;
+            float lproj = glm::length(v2 - v0 - up * glm::dot(v2 - v0, up));
+            glm::vec3 v1 = v0 + height * up * std::max(1.f - lproj / height, 0.05f * std::max(lproj / height, 1.f));
+
+            v2 -= up * std::min(glm::dot(up, v2 - v0), 0.f);
+            float L0 = glm::distance(v0, v2);
+            float L1 = glm::distance(v0, v1) + glm::distance(v1, v2);
+            float L = (2.f * L0 + L1) / 3.f;
+            float r = height / L;
+            v1 = v0 + r * (v1 - v0);
+            v2 = v1 + r * (v2 - v1);
+
+            batch.v1x[i] = QuantizeOffset(v1.x, v0.x);
+            batch.v1y[i] = QuantizeOffset(v1.y, v0.y);
+            batch.v1z[i] = QuantizeOffset(v1.z, v0.z);
+            batch.v2x[i] = QuantizeOffset(v2.x, v0.x);
+            batch.v2y[i] = QuantizeOffset(v2.y, v0.y);
+            batch.v2z[i] = QuantizeOffset(v2.z, v0.z);
+        }
+    }
+
+    void Simulate(BladeBatch& batch, const WindParams& wind, const NoiseField& noise, float deltaTime, float totalTime) {
+        const size_t count = batch.Size();
+        size_t i = 0;
+
+#if GRASS_SIMULATION_SSE
+        const __m128 zero = _mm_setzero_ps();
+        const __m128 one = _mm_set1_ps(1.f);
+        const __m128 third = _mm_set1_ps(1.f / 3.f);
+        const __m128 signMask = _mm_set1_ps(-0.f);
+        const __m128 dt = _mm_set1_ps(deltaTime);
+        const __m128 gravityDown = _mm_set1_ps(-wind.gravity);
+        const __m128 gravityFront = _mm_set1_ps(0.25f * wind.gravity);
+
+        for (; i + 4 <= count; i += 4) {
+            // The noise lookup is a gather, so it stays scalar
+            alignas(16) float wx[4], wy[4], wz[4];
+            for (size_t k = 0; k < 4; ++k) {
+                glm::vec3 w = BaseWindForce(wind, noise, batch.v0x[i + k], batch.v0z[i + k], totalTime);
+                wx[k] = w.x; wy[k] = w.y; wz[k] = w.z;
+            }
+
+            __m128 v0x = _mm_loadu_ps(&batch.v0x[i]), v0y = _mm_loadu_ps(&batch.v0y[i]), v0z = _mm_loadu_ps(&batch.v0z[i]);
+            __m128 v2x = _mm_loadu_ps(&batch.v2x[i]), v2y = _mm_loadu_ps(&batch.v2y[i]), v2z = _mm_loadu_ps(&batch.v2z[i]);
+            __m128 height = _mm_loadu_ps(&batch.height[i]);
+            __m128 stiffness = _mm_loadu_ps(&batch.stiffness[i]);
+            __m128 norx = _mm_loadu_ps(&batch.norx[i]), norz = _mm_loadu_ps(&batch.norz[i]);
+
+            // gravity + recovery
+            __m128 fx = _mm_add_ps(_mm_mul_ps(gravityFront, norx), _mm_mul_ps(_mm_sub_ps(v0x, v2x), stiffness));
+            __m128 fy = _mm_add_ps(gravityDown, _mm_mul_ps(_mm_sub_ps(_mm_add_ps(v0y, height), v2y), stiffness));
+            __m128 fz = _mm_add_ps(_mm_mul_ps(gravityFront, norz), _mm_mul_ps(_mm_sub_ps(v0z, v2z), stiffness));
+
+            // wind
+            __m128 windx = _mm_load_ps(wx), windy = _mm_load_ps(wy), windz = _mm_load_ps(wz);
+            __m128 dx = _mm_sub_ps(v2x, v0x), dy = _mm_sub_ps(v2y, v0y), dz = _mm_sub_ps(v2z, v0z);
+            __m128 cosine = _mm_add_ps(_mm_add_ps(_mm_mul_ps(windx, dx), _mm_mul_ps(windy, dy)), _mm_mul_ps(windz, dz));
+            cosine = _mm_div_ps(cosine, _mm_mul_ps(Length(windx, windy, windz), Length(dx, dy, dz)));
+            __m128 windDir = _mm_sub_ps(one, _mm_andnot_ps(signMask, cosine));
+            __m128 windScale = _mm_mul_ps(windDir, _mm_div_ps(dy, height));
+            fx = _mm_add_ps(fx, _mm_mul_ps(windx, windScale));
+            fy = _mm_add_ps(fy, _mm_mul_ps(windy, windScale));
+            fz = _mm_add_ps(fz, _mm_mul_ps(windz, windScale));
+
+            // update
+            __m128 nv2x = _mm_add_ps(v2x, _mm_mul_ps(fx, dt));
+            __m128 nv2y = _mm_add_ps(v2y, _mm_mul_ps(fy, dt));
+            __m128 nv2z = _mm_add_ps(v2z, _mm_mul_ps(fz, dt));
+            dx = _mm_sub_ps(nv2x, v0x);
+            dz = _mm_sub_ps(nv2z, v0z);
+            __m128 ratio = _mm_div_ps(_mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dz, dz))), height);
+            __m128 v1Height = _mm_mul_ps(height, _mm_max_ps(_mm_sub_ps(one, ratio), _mm_mul_ps(_mm_set1_ps(0.05f), _mm_max_ps(ratio, one))));
+            __m128 nv1x = v0x, nv1y = _mm_add_ps(v0y, v1Height), nv1z = v0z;
+
+            nv2y = _mm_sub_ps(nv2y, _mm_min_ps(_mm_sub_ps(nv2y, v0y), zero));
+            dy = _mm_sub_ps(nv2y, v0y);
+            __m128 L0 = Length(dx, dy, dz);
+            __m128 L1 = _mm_add_ps(v1Height, Length(_mm_sub_ps(nv2x, nv1x), _mm_sub_ps(nv2y, nv1y), _mm_sub_ps(nv2z, nv1z)));
+            __m128 L = _mm_mul_ps(_mm_add_ps(_mm_add_ps(L0, L0), L1), third);
+            __m128 r = _mm_div_ps(height, L);
+            nv1y = _mm_add_ps(v0y, _mm_mul_ps(r, v1Height));
+            nv2x = _mm_add_ps(nv1x, _mm_mul_ps(r, _mm_sub_ps(nv2x, nv1x)));
+            // Same as the shader, v2 is scaled about the already corrected v1
+            nv2y = _mm_add_ps(nv1y, _mm_mul_ps(r, _mm_sub_ps(nv2y, nv1y)));
+            nv2z = _mm_add_ps(nv1z, _mm_mul_ps(r, _mm_sub_ps(nv2z, nv1z)));
+
+            // Unused slots of sparse tiles keep their state
+            __m128 live = _mm_cmpneq_ps(height, zero);
+            _mm_storeu_ps(&batch.v1x[i], Select(live, QuantizeOffset(nv1x, v0x), _mm_loadu_ps(&batch.v1x[i])));
+            _mm_storeu_ps(&batch.v1y[i], Select(live, QuantizeOffset(nv1y, v0y), _mm_loadu_ps(&batch.v1y[i])));
+            _mm_storeu_ps(&batch.v1z[i], Select(live, QuantizeOffset(nv1z, v0z), _mm_loadu_ps(&batch.v1z[i])));
+            _mm_storeu_ps(&batch.v2x[i], Select(live, QuantizeOffset(nv2x, v0x), v2x));
+            _mm_storeu_ps(&batch.v2y[i], Select(live, QuantizeOffset(nv2y, v0y), v2y));
+            _mm_storeu_ps(&batch.v2z[i], Select(live, QuantizeOffset(nv2z, v0z), v2z));
+        }
+#endif
+
+        // Remainder, or everything without SSE
+        SimulateScalar(batch, i, count, wind, noise, deltaTime, totalTime);
+    }
+
+    void SimulateTiles(std::vector<BladeBatch>& tiles, const WindParams& wind, const NoiseField& noise, float deltaTime, float totalTime, uint32_t threadCount) {
+        if (threadCount == 0) {
+            threadCount = std::max(1u, std::thread::hardware_concurrency());
+        }
+        threadCount = std::min(threadCount, static_cast<uint32_t>(tiles.size()));
+
+        // Tiles are independent, threads pull the next one until none are left
+        std::atomic<size_t> nextTile(0);
+        auto worker = [&]() {
+            for (size_t t = nextTile++; t < tiles.size(); t = nextTile++) {
+                Simulate(tiles[t], wind, noise, deltaTime, totalTime);
+            }
+        };
+
+        std::vector<std::thread> threads;
+        for (uint32_t t = 1; t < threadCount; ++t) {
+            threads.emplace_back(worker);
+        }
+        worker();
+        for (std::thread& thread : threads) {
+            thread.join();
+        }
+    }
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <vector>
+
+#include "BladePacking.h"
+
+// CPU reference of the blade forces in shaders/compute.comp: gravity, recovery, wind and the length
+// correction, keep those in sync. Collider pushes, sleeping and distance bands are GPU only, so the
+// tests compare against a capture taken without them. Wind is sampled from the noise directly rather
+// than through the GPU's half float wind field.
+// Nothing in here depends on Vulkan or GLFW so it can run on machines without a GPU
+
+namespace GrassSimulation {
+    // Force constants, defaults match compute.comp
+    struct WindParams {
+        float gravity = 2.f;
+        float windStrength = 40.f;
+        float windSpeed = 2.5f;
+        float windDown = -0.5f;
+        float windAngleVariance = 2.2f;
+
+        // Reeds are blown harder but in a steadier direction
+        static WindParams ForReeds();
+    };
+
+    // RGB noise texture sampled like the renderer's noise sampler (bilinear, repeat, no mips)
+    class NoiseField {
+    public:
+        NoiseField() = default;
+        NoiseField(uint32_t width, uint32_t height, const uint8_t* rgba);
+
+        glm::vec3 Sample(glm::vec2 uv) const;
+
+        bool Empty() const { return texels.empty(); }
+
+    private:
+        uint32_t width = 0;
+        uint32_t height = 0;
+        std::vector<glm::vec3> texels;
+    };
+
+    // Structure of arrays copy of a tile, one entry per blade in each array
+    struct BladeBatch {
+        std::vector<float> v0x, v0y, v0z;
+        std::vector<float> v1x, v1y, v1z;
+        std::vector<float> v2x, v2y, v2z;
+        std::vector<float> height;
+        std::vector<float> stiffness;
+        // normalize(cross(up, dir)), the y component is always 0
+        std::vector<float> norx, norz;
+
+        size_t Size() const { return v0x.size(); }
+        void Resize(size_t count);
+
+        void Load(const BladeStatic* bladesStatic, const BladeDynamic* bladesDynamic, size_t count);
+        void Store(BladeDynamic* bladesDynamic) const;
+    };
+
+    // Advance blades [first, last) of a batch by one step
+    void SimulateScalar(BladeBatch& batch, size_t first, size_t last, const WindParams& wind, const NoiseField& noise, float deltaTime, float totalTime);
+
+    // Same as SimulateScalar, four blades at a time where SSE2 is available
+    void Simulate(BladeBatch& batch, const WindParams& wind, const NoiseField& noise, float deltaTime, float totalTime);
+
+    // Simulate every tile, spread over threadCount threads (0 picks the hardware concurrency)
+    void SimulateTiles(std::vector<BladeBatch>& tiles, const WindParams& wind, const NoiseField& noise, float deltaTime, float totalTime, uint32_t threadCount = 0);
+}
@@ -0,0 +1,318 @@
+#include "MeshUtils.h"
+#include "tiny_obj_loader.h"
+
+#include <iostream>
+#include <stdexcept>
+#include <unordered_map>
+
+namespace {
+    // Triangles per reed leaf in the source OBJ, leaf 0 is the stem
+    constexpr uint32_t REED_TRIANGLES_PER_LEAF = 12;
+
+    // Clustering cell size of each LOD in mesh units, LOD 0 is the source mesh
+    constexpr float REED_LOD_CELL_SIZE[REED_LOD_COUNT] = { 0.f, 0.05f, 0.15f, 0.3f };
+
+    struct ReedVertexHash {
+        size_t operator()(const ReedVertex& v) const {
+            uint64_t h = 14695981039346656037ull;
+            const uint32_t words[4] = { v.pos.x, v.pos.y, v.normal.x, v.normal.y };
+            for (uint32_t w : words) {
+                h ^= w;
+                h *= 1099511628211ull;
+            }
+            return static_cast<size_t>(h);
+        }
+    };
+
+    struct ReedVertexEqual {
+        bool operator()(const ReedVertex& a, const ReedVertex& b) const {
+            return a.pos == b.pos && a.normal == b.normal;
+        }
+    };
+}
+
+ReedVertex MeshUtils::PackReedVertex(const MeshCorner& corner) {
+    ReedVertex vertex;
+    vertex.pos = glm::uvec2(glm::packHalf2x16(glm::vec2(corner.pos.x, corner.pos.y)),
+                            glm::packHalf2x16(glm::vec2(corner.pos.z, static_cast<float>(corner.leafID))));
+    vertex.normal = glm::uvec2(glm::packSnorm2x16(glm::vec2(corner.normal.x, corner.normal.y)),
+                               glm::packSnorm2x16(glm::vec2(corner.normal.z, 0.f)));
+    return vertex;
+}
+
+void MeshUtils::WeldVertices(const std::vector<MeshCorner>& corners, std::vector<ReedVertex>& vertices, std::vector<uint32_t>& indices) {
+    std::unordered_map<ReedVertex, uint32_t, ReedVertexHash, ReedVertexEqual> remap;
+    remap.reserve(corners.size());
+    vertices.clear();
+    indices.clear();
+    indices.reserve(corners.size());
+
+    for (const MeshCorner& corner : corners) {
+        ReedVertex vertex = PackReedVertex(corner);
+        auto it = remap.find(vertex);
+        if (it == remap.end()) {
+            it = remap.emplace(vertex, static_cast<uint32_t>(vertices.size())).first;
+            vertices.push_back(vertex);
+        }
+        indices.push_back(it->second);
+    }
+}
+
+// ref: Sander, Nehab, Barczak, "Fast Triangle Reordering for Vertex Locality and Reduced Overdraw", 2007
+void MeshUtils::OptimizeVertexCache(std::vector<uint32_t>& indices, size_t vertexCount, uint32_t cacheSize) {
+    size_t triangleCount = indices.size() / 3;
+    if (triangleCount == 0) return;
+
+    // Vertex to triangle adjacency
+    std::vector<uint32_t> liveCount(vertexCount, 0);
+    for (uint32_t index : indices) liveCount[index]++;
+
+    std::vector<uint32_t> adjacencyOffset(vertexCount + 1, 0);
+    for (size_t v = 0; v < vertexCount; v++) adjacencyOffset[v + 1] = adjacencyOffset[v] + liveCount[v];
+
+    std::vector<uint32_t> adjacency(indices.size());
+    std::vector<uint32_t> fill(adjacencyOffset.begin(), adjacencyOffset.end() - 1);
+    for (size_t i = 0; i < indices.size(); i++) adjacency[fill[indices[i]]++] = static_cast<uint32_t>(i / 3);
+
+    std::vector<uint32_t> cacheTime(vertexCount, 0);
+    std::vector<bool> emitted(triangleCount, false);
+    std::vector<uint32_t> deadEnd;
+    std::vector<uint32_t> candidates;
+    std::vector<uint32_t> result;
+    result.reserve(indices.size());
+
+    uint32_t time = cacheSize + 1;
+    size_t cursor = 0;
+    int64_t fanning = 0;
+
+    while (fanning >= 0) {
+        candidates.clear();
+
+        // Emit every remaining triangle around the fanning vertex
+        for (uint32_t a = adjacencyOffset[fanning]; a < adjacencyOffset[fanning + 1]; a++) {
+            uint32_t triangle = adjacency[a];
+            if (emitted[triangle]) continue;
+
+            for (int k = 0; k < 3; k++) {
+                uint32_t v = indices[3 * triangle + k];
+                result.push_back(v);
+                deadEnd.push_back(v);
+                candidates.push_back(v);
+                liveCount[v]--;
+                if (time - cacheTime[v] > cacheSize) {
+                    cacheTime[v] = time++;
+                }
+            }
+            emitted[triangle] = true;
+        }
+
+        // Prefer the candidate that is still in cache and has the fewest live triangles
+        fanning = -1;
+        int64_t bestPriority = -1;
+        for (uint32_t v : candidates) {
+            if (liveCount[v] == 0) continue;
+            int64_t priority = 0;
+            if (time - cacheTime[v] + 2 * liveCount[v] <= cacheSize) {
+                priority = time - cacheTime[v];
+            }
+            if (priority > bestPriority) {
+                bestPriority = priority;
+                fanning = v;
+            }
+        }
+
+        // Dead end, back track through recently used vertices then scan
+        if (fanning < 0) {
+            while (!deadEnd.empty() && fanning < 0) {
+                uint32_t v = deadEnd.back();
+                deadEnd.pop_back();
+                if (liveCount[v] > 0) fanning = v;
+            }
+            while (cursor < vertexCount && fanning < 0) {
+                if (liveCount[cursor] > 0) fanning = static_cast<int64_t>(cursor);
+                cursor++;
+            }
+        }
+    }
+
+    indices.swap(result);
+}
+
+void MeshUtils::OptimizeVertexFetch(std::vector<ReedVertex>& vertices, std::vector<uint32_t>& indices) {
+    const uint32_t unused = ~0u;
+    std::vector<uint32_t> remap(vertices.size(), unused);
+    std::vector<ReedVertex> reordered;
+    reordered.reserve(vertices.size());
+
+    for (uint32_t& index : indices) {
+        if (remap[index] == unused) {
+            remap[index] = static_cast<uint32_t>(reordered.size());
+            reordered.push_back(vertices[index]);
+        }
+        index = remap[index];
+    }
+
+    vertices.swap(reordered);
+}
+
+void MeshUtils::SimplifyClusters(const std::vector<ReedVertex>& vertices, const std::vector<uint32_t>& indices, float cellSize,
+    std::vector<ReedVertex>& outVertices, std::vector<uint32_t>& outIndices) {
+    struct Cluster {
+        glm::vec3 pos;
+        glm::vec3 normal;
+        uint32_t leafID;
+        uint32_t count;
+    };
+
+    // Key: grid cell and leaf, leaves must not merge or their waving breaks apart
+    std::unordered_map<uint64_t, uint32_t> cellToCluster;
+    std::vector<Cluster> clusters;
+    std::vector<uint32_t> vertexCluster(vertices.size());
+
+    for (size_t i = 0; i < vertices.size(); i++) {
+        glm::vec2 xy = glm::unpackHalf2x16(vertices[i].pos.x);
+        glm::vec2 zw = glm::unpackHalf2x16(vertices[i].pos.y);
+        glm::vec3 pos(xy.x, xy.y, zw.x);
+        uint32_t leafID = static_cast<uint32_t>(zw.y);
+        glm::vec2 nxy = glm::unpackSnorm2x16(vertices[i].normal.x);
+        glm::vec3 normal(nxy.x, nxy.y, glm::unpackSnorm2x16(vertices[i].normal.y).x);
+
+        glm::ivec3 cell = glm::ivec3(glm::floor(pos / cellSize));
+        uint64_t key = (uint64_t(uint32_t(cell.x) & 0xffffu) << 48) | (uint64_t(uint32_t(cell.y) & 0xffffu) << 32) |
+            (uint64_t(uint32_t(cell.z) & 0xffffu) << 16) | uint64_t(leafID & 0xffffu);
+
+        auto it = cellToCluster.find(key);
+        if (it == cellToCluster.end()) {
+            it = cellToCluster.emplace(key, static_cast<uint32_t>(clusters.size())).first;
+            Cluster cluster = { glm::vec3(0.f), glm::vec3(0.f), leafID, 0 };
+            clusters.push_back(cluster);
+        }
+        Cluster& cluster = clusters[it->second];
+        cluster.pos += pos;
+        cluster.normal += normal;
+        cluster.count++;
+        vertexCluster[i] = it->second;
+    }
+
+    // Keep triangles that still span three clusters
+    std::vector<uint32_t> clusterIndices;
+    for (size_t t = 0; t + 2 < indices.size(); t += 3) {
+        uint32_t a = vertexCluster[indices[t]], b = vertexCluster[indices[t + 1]], c = vertexCluster[indices[t + 2]];
+        if (a == b || b == c || a == c) continue;
+        clusterIndices.push_back(a);
+        clusterIndices.push_back(b);
+        clusterIndices.push_back(c);
+    }
+
+    std::vector<MeshCorner> corners;
+    corners.reserve(clusterIndices.size());
+    for (uint32_t index : clusterIndices) {
+        const Cluster& cluster = clusters[index];
+        MeshCorner corner;
+        corner.pos = cluster.pos / static_cast<float>(cluster.count);
+        float length = glm::length(cluster.normal);
+        corner.normal = length > 0.f ? cluster.normal / length : glm::vec3(0.f, 1.f, 0.f);
+        corner.leafID = cluster.leafID;
+        corners.push_back(corner);
+    }
+
+    WeldVertices(corners, outVertices, outIndices);
+}
+
+float MeshUtils::ComputeACMR(const std::vector<uint32_t>& indices, size_t vertexCount, uint32_t cacheSize) {
+    size_t triangleCount = indices.size() / 3;
+    if (triangleCount == 0) return 0.f;
+
+    // FIFO cache, a vertex is resident if it was inserted in the last cacheSize misses
+    std::vector<uint32_t> insertedAt(vertexCount, 0);
+    uint32_t misses = 0;
+    for (uint32_t index : indices) {
+        if (insertedAt[index] == 0 || misses - insertedAt[index] >= cacheSize) {
+            misses++;
+            insertedAt[index] = misses;
+        }
+    }
+    return static_cast<float>(misses) / triangleCount;
+}
+
+void MeshUtils::LoadReedCorners(const std::string& file, std::vector<MeshCorner>& corners) {
+    tinyobj::attrib_t attrib;
+    std::vector<tinyobj::shape_t> shapes;
+    std::vector<tinyobj::material_t> materials;
+
+    std::string err;
+
+    bool ret = tinyobj::LoadObj(&attrib, &shapes, &materials, &err, file.c_str());
+
+    if (!ret || shapes.empty())
+    {
+        std::cerr << err << std::endl;
+        throw std::runtime_error("Failed to load reed object");
+    }
+
+    corners.clear();
+    const tinyobj::mesh_t& mesh = shapes[0].mesh;
+    size_t index_offset = 0;
+    for (size_t f = 0; f < mesh.num_face_vertices.size(); f++) {
+        size_t fv = size_t(mesh.num_face_vertices[f]);
+
+        // Loop over vertices in the face.
+        for (size_t v = 0; v < fv; v++) {
+            MeshCorner corner = {};
+            tinyobj::index_t idx = mesh.indices[index_offset + v];
+
+            corner.pos.x = attrib.vertices[3 * size_t(idx.vertex_index) + 0] / 2.f;
+            corner.pos.y = attrib.vertices[3 * size_t(idx.vertex_index) + 1] / 2.f;
+            corner.pos.z = attrib.vertices[3 * size_t(idx.vertex_index) + 2] / 4.f;
+
+            // Check if `normal_index` is zero or positive. negative = no normal data
+            if (idx.normal_index >= 0) {
+                corner.normal.x = attrib.normals[3 * size_t(idx.normal_index) + 0];
+                corner.normal.y = attrib.normals[3 * size_t(idx.normal_index) + 1];
+                corner.normal.z = attrib.normals[3 * size_t(idx.normal_index) + 2];
+            }
+
+            corner.leafID = static_cast<uint32_t>(f / REED_TRIANGLES_PER_LEAF);
+            corners.push_back(corner);
+        }
+        index_offset += fv;
+    }
+}
+
+void MeshUtils::LoadReedMesh(const std::string& file, std::vector<ReedVertex>& vertices, std::vector<uint32_t>& indices, ReedMeshRange lods[REED_LOD_COUNT]) {
+    std::vector<MeshCorner> corners;
+    LoadReedCorners(file, corners);
+
+    std::vector<ReedVertex> baseVertices;
+    std::vector<uint32_t> baseIndices;
+    WeldVertices(corners, baseVertices, baseIndices);
+    float acmrBefore = ComputeACMR(baseIndices, baseVertices.size());
+
+    std::cout << file << ": " << corners.size() << " corners -> " << baseVertices.size() << " vertices, "
+        << "ACMR " << static_cast<float>(corners.size()) / (corners.size() / 3) << " unindexed, " << acmrBefore << " welded" << std::endl;
+
+    vertices.clear();
+    indices.clear();
+    for (uint32_t l = 0; l < REED_LOD_COUNT; l++) {
+        std::vector<ReedVertex> lodVertices;
+        std::vector<uint32_t> lodIndices;
+        if (l == 0) {
+            lodVertices = baseVertices;
+            lodIndices = baseIndices;
+        }
+        else {
+            SimplifyClusters(baseVertices, baseIndices, REED_LOD_CELL_SIZE[l], lodVertices, lodIndices);
+        }
+        OptimizeVertexCache(lodIndices, lodVertices.size());
+        OptimizeVertexFetch(lodVertices, lodIndices);
+
+        lods[l].firstIndex = static_cast<uint32_t>(indices.size());
+        lods[l].indexCount = static_cast<uint32_t>(lodIndices.size());
+        lods[l].vertexOffset = static_cast<int32_t>(vertices.size());
+        vertices.insert(vertices.end(), lodVertices.begin(), lodVertices.end());
+        indices.insert(indices.end(), lodIndices.begin(), lodIndices.end());
+
+        std::cout << "  LOD " << l << ": " << lodIndices.size() / 3 << " triangles, " << lodVertices.size() << " vertices, "
+            << "ACMR " << ComputeACMR(lodIndices, lodVertices.size()) << std::endl;
+    }
+}
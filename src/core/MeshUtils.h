@@ -0,0 +1,44 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <string>
+#include <vector>
+
+#include "ReedMesh.h"
+
+// Cache size used for vertex cache optimisation and ACMR reporting
+constexpr static uint32_t VERTEX_CACHE_SIZE = 16;
+
+// Full precision face corner, only used while importing
+struct MeshCorner {
+    glm::vec3 pos;
+    glm::vec3 normal;
+    uint32_t leafID;
+};
+
+namespace MeshUtils {
+    ReedVertex PackReedVertex(const MeshCorner& corner);
+
+    // Merge identical packed vertices, indices has one entry per corner
+    void WeldVertices(const std::vector<MeshCorner>& corners, std::vector<ReedVertex>& vertices, std::vector<uint32_t>& indices);
+
+    // Reorder triangles for post-transform cache locality (Tipsify)
+    void OptimizeVertexCache(std::vector<uint32_t>& indices, size_t vertexCount, uint32_t cacheSize = VERTEX_CACHE_SIZE);
+
+    // Renumber vertices in first use order so fetches are sequential
+    void OptimizeVertexFetch(std::vector<ReedVertex>& vertices, std::vector<uint32_t>& indices);
+
+    // Vertex clustering simplification, vertices only merge within a cell and leaf
+    void SimplifyClusters(const std::vector<ReedVertex>& vertices, const std::vector<uint32_t>& indices, float cellSize,
+        std::vector<ReedVertex>& outVertices, std::vector<uint32_t>& outIndices);
+
+    // Average cache miss ratio of a triangle list with a FIFO cache
+    float ComputeACMR(const std::vector<uint32_t>& indices, size_t vertexCount, uint32_t cacheSize = VERTEX_CACHE_SIZE);
+
+    // Read the face corners of a reed OBJ, leaf IDs are assigned from the face order
+    void LoadReedCorners(const std::string& file, std::vector<MeshCorner>& corners);
+
+    // Load a reed OBJ as a welded, cache optimised indexed mesh with its LOD chain.
+    // LODs are stored back to back, indices are relative to each LOD's vertexOffset
+    void LoadReedMesh(const std::string& file, std::vector<ReedVertex>& vertices, std::vector<uint32_t>& indices, ReedMeshRange lods[REED_LOD_COUNT]);
+}
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <cstdint>
+
+// Reed meshes packed into the shared vertex/index buffers
+constexpr static uint32_t REED_VARIANT_COUNT = 4;
+constexpr static uint32_t REED_LOD_COUNT = 4;
+
+// 16 bytes: position as half4 (w: leaf id), normal as snorm16x4
+struct ReedVertex {
+	glm::uvec2 pos;
+	glm::uvec2 normal;
+};
+
+static_assert(sizeof(ReedVertex) == 16, "ReedVertex must match the reed vertex attributes");
+
+// Range of one mesh LOD in the shared reed buffers
+struct ReedMeshRange {
+    uint32_t firstIndex;
+    uint32_t indexCount;
+    int32_t vertexOffset;
+};
@@ -0,0 +1,239 @@
+#include "SceneConfig.h"
+
+#include <cerrno>
+#include <cstdlib>
+#include <fstream>
+#include <stdexcept>
+
+namespace {
+    std::string Trim(const std::string& s) {
+        size_t first = s.find_first_not_of(" \t\r");
+        if (first == std::string::npos) return "";
+        size_t last = s.find_last_not_of(" \t\r");
+        return s.substr(first, last - first + 1);
+    }
+
+    uint64_t ParseUint64(const std::string& key, const std::string& value) {
+        char* end = nullptr;
+        errno = 0;
+        long long parsed = std::strtoll(value.c_str(), &end, 10);
+        if (value.empty() || *end != '\0' || parsed < 0 || errno == ERANGE) {
+            throw std::runtime_error("Invalid value for " + key + ": " + value);
+        }
+        return static_cast<uint64_t>(parsed);
+    }
+
+    uint32_t ParseUint(const std::string& key, const std::string& value) {
+        uint64_t parsed = ParseUint64(key, value);
+        if (parsed > UINT32_MAX) {
+            throw std::runtime_error("Invalid value for " + key + ": " + value);
+        }
+        return static_cast<uint32_t>(parsed);
+    }
+
+    float ParseFloat(const std::string& key, const std::string& value) {
+        char* end = nullptr;
+        float parsed = std::strtof(value.c_str(), &end);
+        if (value.empty() || *end != '\0') {
+            throw std::runtime_error("Invalid value for " + key + ": " + value);
+        }
+        return parsed;
+    }
+
+    std::vector<uint32_t> ParseUintList(const std::string& key, const std::string& value) {
+        std::vector<uint32_t> list;
+        size_t start = 0;
+        while (start <= value.size()) {
+            size_t comma = value.find(',', start);
+            if (comma == std::string::npos) comma = value.size();
+            list.push_back(ParseUint(key, Trim(value.substr(start, comma - start))));
+            start = comma + 1;
+        }
+        return list;
+    }
+
+    std::vector<float> ParseFloatList(const std::string& key, const std::string& value) {
+        std::vector<float> list;
+        size_t start = 0;
+        while (!value.empty() && start <= value.size()) {
+            size_t comma = value.find(',', start);
+            if (comma == std::string::npos) comma = value.size();
+            list.push_back(ParseFloat(key, Trim(value.substr(start, comma - start))));
+            start = comma + 1;
+        }
+        return list;
+    }
+
+    bool ParseBool(const std::string& key, const std::string& value) {
+        if (value == "1" || value == "true" || value == "on") return true;
+        if (value == "0" || value == "false" || value == "off") return false;
+        throw std::runtime_error("Invalid value for " + key + ": " + value);
+    }
+
+    // Shape keys are shared by grass and reeds, prefix is "grass_" or "reed_"
+    bool SetShape(BladeShape& shape, const std::string& prefix, const std::string& key, const std::string& value) {
+        if (key.compare(0, prefix.size(), prefix) != 0) return false;
+        std::string name = key.substr(prefix.size());
+        if (name == "min_height") shape.minHeight = ParseFloat(key, value);
+        else if (name == "max_height") shape.maxHeight = ParseFloat(key, value);
+        else if (name == "min_width") shape.minWidth = ParseFloat(key, value);
+        else if (name == "max_width") shape.maxWidth = ParseFloat(key, value);
+        else if (name == "min_bend") shape.minBend = ParseFloat(key, value);
+        else if (name == "max_bend") shape.maxBend = ParseFloat(key, value);
+        else return false;
+        return true;
+    }
+
+    void ValidateShape(const BladeShape& shape, const std::string& name) {
+        if (shape.minHeight <= 0.f || shape.minHeight > shape.maxHeight ||
+            shape.minWidth <= 0.f || shape.minWidth > shape.maxWidth ||
+            shape.minBend < 0.f || shape.minBend > shape.maxBend) {
+            throw std::runtime_error("Invalid " + name + " ranges, minimums must be positive and no larger than maximums");
+        }
+    }
+}
+
+SceneConfig SceneConfig::Load(int argc, char** argv) {
+    SceneConfig config;
+
+    // The file goes first so arguments override it regardless of their order
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg.compare(0, 9, "--config=") == 0) {
+            config.LoadFile(arg.substr(9));
+        }
+    }
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        size_t equals = arg.find('=');
+        if (arg.compare(0, 2, "--") != 0 || equals == std::string::npos) {
+            throw std::runtime_error("Expected --key=value, got " + arg);
+        }
+        std::string key = arg.substr(2, equals - 2);
+        if (key != "config") {
+            config.Set(key, arg.substr(equals + 1));
+        }
+    }
+
+    config.Validate();
+    return config;
+}
+
+void SceneConfig::LoadFile(const std::string& file) {
+    std::ifstream in(file);
+    if (!in) {
+        throw std::runtime_error("Failed to open scene config " + file);
+    }
+
+    std::string line;
+    while (std::getline(in, line)) {
+        line = Trim(line.substr(0, line.find('#')));
+        if (line.empty()) continue;
+
+        size_t equals = line.find('=');
+        if (equals == std::string::npos) {
+            throw std::runtime_error("Expected key=value in " + file + ": " + line);
+        }
+        Set(Trim(line.substr(0, equals)), Trim(line.substr(equals + 1)));
+    }
+}
+
+void SceneConfig::Set(const std::string& key, const std::string& value) {
+    if (key == "window_width") windowWidth = ParseUint(key, value);
+    else if (key == "window_height") windowHeight = ParseUint(key, value);
+    else if (key == "terrain_width") terrainWidth = ParseUint(key, value);
+    else if (key == "terrain_depth") terrainDepth = ParseUint(key, value);
+    else if (key == "plane_dim") planeDim = ParseFloat(key, value);
+    else if (key == "reed_scale") reedScale = ParseUint(key, value);
+    else if (key == "blades_per_tile") grass.bladesPerTile = ParseUint(key, value);
+    else if (key == "use_clump") grass.useClump = ParseBool(key, value);
+    else if (key == "reeds_per_side") reeds.reedsPerSide = ParseUint(key, value);
+    else if (key == "uniform_spawn") reeds.uniformSpawn = ParseBool(key, value);
+    else if (key == "sim_bands") simulationBands = ParseFloatList(key, value);
+    else if (key == "colliders") colliders = ParseUint(key, value);
+    else if (key == "collider_radius") colliderRadius = ParseFloat(key, value);
+    else if (key == "warm_start_steps") warmStartSteps = ParseUint(key, value);
+    else if (key == "warm_start_step") warmStartStep = ParseFloat(key, value);
+    else if (key == "snapshot") snapshot = value;
+    else if (key == "snapshot_settled") snapshotSettled = ParseBool(key, value);
+    else if (key == "capture_simulation") captureSimulation = value;
+    else if (key == "sweep") sweep.enabled = ParseBool(key, value);
+    else if (key == "sweep_blades") sweep.bladesPerTile = ParseUintList(key, value);
+    else if (key == "sweep_tiles") sweep.tileCounts = ParseUintList(key, value);
+    else if (key == "sweep_reeds") sweep.reedsPerSide = value.empty() ? std::vector<uint32_t>() : ParseUintList(key, value);
+    else if (key == "sweep_max_blades") sweep.maxBlades = ParseUint64(key, value);
+    else if (key == "sweep_warmup_frames") sweep.warmupFrames = ParseUint(key, value);
+    else if (key == "sweep_frames") sweep.frames = ParseUint(key, value);
+    else if (key == "sweep_output") sweep.output = value;
+    else if (!SetShape(grass.shape, "grass_", key, value) && !SetShape(reeds.shape, "reed_", key, value)) {
+        throw std::runtime_error("Unknown scene setting " + key);
+    }
+}
+
+void SceneConfig::Validate() const {
+    if (windowWidth == 0 || windowHeight == 0) {
+        throw std::runtime_error("Window size must be non-zero");
+    }
+    if (planeDim <= 0.f || reedScale == 0) {
+        throw std::runtime_error("plane_dim and reed_scale must be positive");
+    }
+    if (terrainWidth == 0 || terrainDepth == 0) {
+        throw std::runtime_error("terrain_width and terrain_depth must be positive");
+    }
+
+    // Culled lists hold 16-bit indices two to a word, so each tile's range must fit and start on a whole word
+    if (grass.bladesPerTile == 0 || grass.bladesPerTile > MAX_BLADES_PER_TILE || grass.bladesPerTile % 2 != 0) {
+        throw std::runtime_error("blades_per_tile must be even and at most " + std::to_string(MAX_BLADES_PER_TILE));
+    }
+    // Bound the side before squaring it, ReedsPerTile() wraps past 65535 per side
+    if (reeds.reedsPerSide == 0 || reeds.reedsPerSide > 256 || reeds.ReedsPerTile() > MAX_BLADES_PER_TILE || reeds.reedsPerSide % 2 != 0) {
+        throw std::runtime_error("reeds_per_side must be even and its square at most " + std::to_string(MAX_BLADES_PER_TILE));
+    }
+
+    ValidateShape(grass.shape, "grass");
+    ValidateShape(reeds.shape, "reed");
+
+    if (simulationBands.size() > 3) {
+        throw std::runtime_error("sim_bands takes at most 3 distances");
+    }
+    for (size_t b = 0; b < simulationBands.size(); ++b) {
+        if (simulationBands[b] <= 0.f || (b > 0 && simulationBands[b] <= simulationBands[b - 1])) {
+            throw std::runtime_error("sim_bands must be positive and ascending");
+        }
+    }
+
+    if (colliderRadius <= 0.f) {
+        throw std::runtime_error("collider_radius must be positive");
+    }
+
+    if (warmStartStep <= 0.f || warmStartStep > 0.2f) {
+        throw std::runtime_error("warm_start_step must be in (0, 0.2]");
+    }
+
+    // The CPU simulation has no colliders or sleep, so captures stop before a blade could fall asleep
+    if (!captureSimulation.empty() && (colliders != 0 || warmStartSteps == 0 || warmStartSteps > 15)) {
+        throw std::runtime_error("capture_simulation needs no colliders and 1 to 15 warm_start_steps");
+    }
+
+    if (sweep.enabled) {
+        for (uint32_t blades : sweep.bladesPerTile) {
+            if (blades == 0 || blades > MAX_BLADES_PER_TILE || blades % 2 != 0) {
+                throw std::runtime_error("sweep_blades entries must be even and at most " + std::to_string(MAX_BLADES_PER_TILE));
+            }
+        }
+        for (uint32_t reeds : sweep.reedsPerSide) {
+            if (reeds == 0 || reeds > 256 || reeds % 2 != 0) {
+                throw std::runtime_error("sweep_reeds entries must be even and at most 256");
+            }
+        }
+        for (uint32_t tiles : sweep.tileCounts) {
+            if (tiles == 0) {
+                throw std::runtime_error("sweep_tiles entries must be positive");
+            }
+        }
+        if (sweep.frames == 0 || sweep.output.empty()) {
+            throw std::runtime_error("sweep_frames must be positive and sweep_output set");
+        }
+    }
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "BladeGeneration.h"
+
+// Scene scale and placement settings, read at startup so experiments don't need a rebuild.
+//
+// Settings come from an optional file of key=value lines (# starts a comment) given with
+// --config=path, then from --key=value arguments which override the file. Keys:
+//   window_width, window_height           window size in pixels
+//   terrain_width, terrain_depth          grass tiles along x and z
+//   plane_dim                             side length of a grass tile
+//   reed_scale                            grass tiles per reed tile along each axis
+//   blades_per_tile, use_clump            grass placement
+//   grass_min_height ... grass_max_bend   grass attribute ranges
+//   reeds_per_side, uniform_spawn         reed placement
+//   reed_min_height ... reed_max_bend     reed attribute ranges
+//   sim_bands                             up to 3 ascending camera distances where blades start stepping
+//                                         every 2nd, 4th and 8th frame, empty steps everything every frame
+//   warm_start_steps, warm_start_step     simulation steps and step length in seconds run at load
+//   colliders, collider_radius            test spheres and capsules circling over the terrain, pushing grass aside
+//   snapshot                              blade snapshot file, loaded when it matches the settings above
+//                                         and written after generation otherwise
+//   snapshot_settled                      rewrite the snapshot on exit with the simulated blade state
+//   capture_simulation                    write the grass before and after the warm start to this file and exit,
+//                                         regenerates the capture the simulation tests compare against
+//   sweep                                 run the scalability sweep instead of the interactive viewer
+//   sweep_blades, sweep_tiles             comma separated blades per tile and tile counts to sweep
+//   sweep_reeds                           comma separated reeds_per_side values to sweep, empty keeps reeds_per_side
+//   sweep_max_blades                      configurations with more blades in total are skipped
+//   sweep_warmup_frames, sweep_frames     frames rendered before and while measuring
+//   sweep_output                          CSV file written by the sweep
+
+// Every combination of blade, reed and tile count is rendered in an invisible window and timed
+struct SweepSettings {
+    bool enabled = false;
+    std::vector<uint32_t> bladesPerTile = { 256, 1024, 4096, 16384, 65536 };
+    std::vector<uint32_t> tileCounts = { 1, 4, 16, 64, 256, 1024, 4096, 10000 };
+    std::vector<uint32_t> reedsPerSide;
+    uint64_t maxBlades = 1ull << 25;
+    uint32_t warmupFrames = 30;
+    uint32_t frames = 120;
+    std::string output = "sweep.csv";
+};
+
+struct SceneConfig {
+    uint32_t windowWidth = 1440;
+    uint32_t windowHeight = 1080;
+
+    uint32_t terrainWidth = 20;
+    uint32_t terrainDepth = 20;
+    float planeDim = 15.f;
+    uint32_t reedScale = 20;
+
+    GrassSettings grass;
+    ReedSettings reeds;
+    SweepSettings sweep;
+
+    std::vector<float> simulationBands;
+
+    uint32_t colliders = 0;
+    float colliderRadius = 2.f;
+
+    // Explicit steps stay stable while stiffness * step < 1, the stiffest reeds allow up to 0.2
+    uint32_t warmStartSteps = 40;
+    float warmStartStep = 0.1f;
+
+    std::string snapshot;
+    bool snapshotSettled = false;
+
+    std::string captureSimulation;
+
+    // Throws std::runtime_error on unknown keys, malformed values or settings the renderer can't hold
+    static SceneConfig Load(int argc, char** argv);
+
+    void LoadFile(const std::string& file);
+    void Set(const std::string& key, const std::string& value);
+    void Validate() const;
+};
@@ -0,0 +1,73 @@
+#include "SimulationCapture.h"
+
+#include <fstream>
+
+namespace {
+    template <typename T>
+    bool ReadArray(std::ifstream& in, std::vector<T>& array, size_t count) {
+        array.resize(count);
+        return static_cast<bool>(in.read(reinterpret_cast<char*>(array.data()), count * sizeof(T)));
+    }
+
+    template <typename T>
+    void WriteArray(std::ofstream& out, const std::vector<T>& array) {
+        out.write(reinterpret_cast<const char*>(array.data()), array.size() * sizeof(T));
+    }
+}
+
+bool SimulationCapture::Read(const std::string& path) {
+    std::ifstream in(path, std::ios::binary | std::ios::ate);
+    if (!in) return false;
+    const uint64_t fileSize = static_cast<uint64_t>(in.tellg());
+    in.seekg(0);
+
+    SimulationCaptureHeader header = {};
+    if (!in.read(reinterpret_cast<char*>(&header), sizeof(header)) ||
+        header.magic != SIMULATION_CAPTURE_MAGIC ||
+        header.version != SIMULATION_CAPTURE_VERSION ||
+        header.staticStride != sizeof(BladeStatic) ||
+        header.dynamicStride != sizeof(BladeDynamic)) {
+        return false;
+    }
+
+    // Check the sizes against the file before allocating anything
+    const uint64_t noiseBytes = uint64_t(header.noiseWidth) * header.noiseHeight * 4;
+    const uint64_t bladeBytes = uint64_t(header.bladeCount) * (sizeof(BladeStatic) + 2 * sizeof(BladeDynamic));
+    if (sizeof(header) + noiseBytes + bladeBytes != fileSize) {
+        return false;
+    }
+
+    steps = header.steps;
+    stepSize = header.stepSize;
+    noiseWidth = header.noiseWidth;
+    noiseHeight = header.noiseHeight;
+    return ReadArray(in, noiseRgba, static_cast<size_t>(noiseBytes)) &&
+        ReadArray(in, bladesStatic, header.bladeCount) &&
+        ReadArray(in, before, header.bladeCount) &&
+        ReadArray(in, after, header.bladeCount);
+}
+
+bool SimulationCapture::Write(const std::string& path) const {
+    if (before.size() != bladesStatic.size() || after.size() != bladesStatic.size() || noiseRgba.size() != size_t(noiseWidth) * noiseHeight * 4) {
+        return false;
+    }
+
+    SimulationCaptureHeader header = {};
+    header.magic = SIMULATION_CAPTURE_MAGIC;
+    header.version = SIMULATION_CAPTURE_VERSION;
+    header.staticStride = sizeof(BladeStatic);
+    header.dynamicStride = sizeof(BladeDynamic);
+    header.bladeCount = static_cast<uint32_t>(bladesStatic.size());
+    header.steps = steps;
+    header.stepSize = stepSize;
+    header.noiseWidth = noiseWidth;
+    header.noiseHeight = noiseHeight;
+
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    WriteArray(out, noiseRgba);
+    WriteArray(out, bladesStatic);
+    WriteArray(out, before);
+    WriteArray(out, after);
+    return static_cast<bool>(out);
+}
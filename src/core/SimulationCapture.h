@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "BladePacking.h"
+
+// "GSCP", bump the version whenever BladeStatic, BladeDynamic or the layout below changes
+constexpr static uint32_t SIMULATION_CAPTURE_MAGIC = 0x50435347;
+constexpr static uint32_t SIMULATION_CAPTURE_VERSION = 1;
+
+struct SimulationCaptureHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t staticStride;
+    uint32_t dynamicStride;
+    uint32_t bladeCount;
+    // Warm start steps taken between before and after, all at totalTime 0
+    uint32_t steps;
+    float stepSize;
+    uint32_t noiseWidth;
+    uint32_t noiseHeight;
+    // Followed by the noise texels, the static blades, then the dynamic blades before and after
+};
+
+static_assert(sizeof(SimulationCaptureHeader) == 36, "SimulationCaptureHeader is written to disk as is");
+
+// Grass read back from the GPU around the warm start, with the noise texture its wind came from.
+// Written by the renderer's capture_simulation setting, replayed on the CPU by the simulation tests
+struct SimulationCapture {
+    uint32_t steps = 0;
+    float stepSize = 0.f;
+    uint32_t noiseWidth = 0;
+    uint32_t noiseHeight = 0;
+    // RGBA8, as the renderer uploads it
+    std::vector<uint8_t> noiseRgba;
+    std::vector<BladeStatic> bladesStatic;
+    std::vector<BladeDynamic> before;
+    std::vector<BladeDynamic> after;
+
+    // False when the file is missing, truncated or from another version
+    bool Read(const std::string& path);
+    bool Write(const std::string& path) const;
+};
@@ -0,0 +1,102 @@
+#include "Terrain.h"
+
+#include <cstdlib>
+
+float snoise(glm::vec2 v)
+{
+    const glm::vec4 C = glm::vec4(0.211324865405187,  // (3.0-sqrt(3.0))/6.0
+        0.366025403784439,  // 0.5*(sqrt(3.0)-1.0)
+        -0.577350269189626,  // -1.0 + 2.0 * C.x
+        0.024390243902439); // 1.0 / 41.0
+    // First corner
+    glm::vec2 i = glm::floor(v + glm::dot(v, glm::vec2(C.y)));
+    glm::vec2 x0 = v - i + glm::dot(i, glm::vec2(C.x));
+
+    // Other corners
+    glm::vec2 i1;
+    i1 = (x0.x > x0.y) ? glm::vec2(1.0, 0.0) : glm::vec2(0.0, 1.0);
+    glm::vec4 x12 = glm::vec4(x0.x, x0.y, x0.x, x0.y) + glm::vec4(C.x, C.x, C.z, C.z);
+    x12.x -= i1.x;
+    x12.y -= i1.y;
+
+    // Permutations
+    i = mod289(i); // Avoid truncation effects in permutation
+    glm::vec3 p = permute(permute(i.y + glm::vec3(0.0, i1.y, 1.0))
+        + i.x + glm::vec3(0.0, i1.x, 1.0));
+
+    glm::vec3 m = glm::max(0.5f - glm::vec3(glm::dot(x0, x0),
+        glm::dot(glm::vec2(x12), glm::vec2(x12)), glm::dot(glm::vec2(x12.z, x12.w), glm::vec2(x12.z, x12.w))), 0.f);
+    m = m * m;
+    m = m * m;
+
+    // Gradients: 41 points uniformly over a line, mapped onto a diamond.
+    // The ring size 17*17 = 289 is close to a multiple of 41 (41*7 = 287)
+
+    glm::vec3 x = 2.f * glm::fract(p * glm::vec3(C.w)) - 1.f;
+    glm::vec3 h = glm::abs(x) - 0.5f;
+    glm::vec3 ox = glm::floor(x + 0.5f);
+    glm::vec3 a0 = x - ox;
+
+    // Normalise gradients implicitly by scaling m
+    // Approximation of: m *= inversesqrt( a0*a0 + h*h );
+    m *= 1.79284291400159f - 0.85373472095314f * (a0 * a0 + h * h);
+
+    // Compute final noise value at P
+    glm::vec3 g;
+    g.x = a0.x * x0.x + h.x * x0.y;
+    glm::vec2 tmp = glm::vec2(a0.y, a0.z) * glm::vec2(x12.x, x12.z) + glm::vec2(h.y, h.z) * glm::vec2(x12.y, x12.w);
+    g.y = tmp.x;
+    g.z = tmp.y;
+    return 130.f * glm::dot(m, g);
+}
+
+float terrainHeight(glm::vec2 v)
+{
+    return snoise(v * 0.01f) * 10.f;
+}
+
+// Finite difference normal of terrainHeight, matches the old normalFromTerrain in the fragment shaders
+glm::vec3 terrainNormal(glm::vec2 v)
+{
+    float eps = 0.01f;
+    float fx0 = terrainHeight(glm::vec2(v.x - eps, v.y)), fx1 = terrainHeight(glm::vec2(v.x + eps, v.y));
+    float fy0 = terrainHeight(glm::vec2(v.x, v.y - eps)), fy1 = terrainHeight(glm::vec2(v.x, v.y + eps));
+    return glm::normalize(glm::vec3((fx0 - fx1) / eps, 1.f, (fy0 - fy1) / eps));
+}
+
+float generateRandomFloat() {
+    return rand() / (float)RAND_MAX;
+}
+
+glm::vec2 hash22(glm::vec2 p)
+{
+    glm::vec3 p3 = glm::fract(glm::vec3(p.x, p.y, p.x) * glm::vec3(.1031, .1030, .0973));
+    p3 += glm::dot(p3, glm::vec3(p3.y, p3.z, p3.x) + 33.33f);
+    return glm::fract((glm::vec2(p3.x, p3.x) + glm::vec2(p3.y, p3.z)) * glm::vec2(p3.z, p3.y));
+}
+
+glm::vec2 hash32(glm::vec3 p3)
+{
+    p3 = glm::fract(p3 * glm::vec3(.1031, .1030, .0973));
+    p3 += glm::dot(p3, glm::vec3(p3.y, p3.z, p3.x) + 33.33f);
+    return glm::fract((glm::vec2(p3.x, p3.x) + glm::vec2(p3.y, p3.z)) * glm::vec2(p3.z, p3.y));
+}
+
+glm::vec4 getNearestClumpGrid(glm::vec2 position) {
+    glm::ivec2 clumpGridID = glm::floor(position / ClumpGridSize);
+    float minDist = 1000000.0f;
+    glm::vec4 out;
+    for (int i = -1; i <= 1; i++) {
+        for (int j = -1; j <= 1; j++) {
+            glm::vec2 currGrid = clumpGridID + glm::ivec2(i, j);
+            glm::vec2 gridOffset = hash22(currGrid) * ClumpGridSize;
+            glm::vec2 gridCenter = currGrid * ClumpGridSize + gridOffset;
+            float dist = glm::distance(position, gridCenter);
+            if (dist < minDist) {
+                minDist = dist;
+                out = glm::vec4(currGrid, gridCenter);
+            }
+        }
+    }
+    return out;
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+// Terrain and placement noise shared by the CPU generators, keep in sync with shaders/generate.comp
+
+constexpr static float ClumpGridSize = 10.0f;
+
+// ref: https://github.com/ashima/webgl-noise/blob/master/src/noise2D.glsl
+inline glm::vec3 mod289(glm::vec3 x) {
+    return x - glm::floor(x * (1.f / 289.f)) * 289.f;
+}
+
+inline glm::vec2 mod289(glm::vec2 x) {
+    return x - glm::floor(x * (1.f / 289.f)) * 289.f;
+}
+
+inline glm::vec3 permute(glm::vec3 x) {
+    return mod289(((x * 34.f) + 10.f) * x);
+}
+
+float snoise(glm::vec2 v);
+
+float terrainHeight(glm::vec2 v);
+
+glm::vec3 terrainNormal(glm::vec2 v);
+
+float generateRandomFloat();
+
+glm::vec2 hash22(glm::vec2 p);
+
+glm::vec2 hash32(glm::vec3 p3);
+
+// xy: clump grid id, zw: clump center
+glm::vec4 getNearestClumpGrid(glm::vec2 position);
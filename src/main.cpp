@@ -5,8 +5,18 @@
 #include "Camera.h"
 #include "Scene.h"
 #include "Image.h"
+#include "BufferUtils.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
 #include <iostream>
-#include "tiny_obj_loader.h"
+#include "MeshCache.h"
+#include "SceneConfig.h"
+#include "SceneSnapshot.h"
+#include "SimulationCapture.h"
+#include "Terrain.h"
+#include <stb_image.h>
 
 Device* device;
 SwapChain* swapChain;
@@ -19,6 +29,7 @@ namespace {
 
         vkDeviceWaitIdle(device->GetVkDevice());
         swapChain->Recreate();
+        camera->SetAspectRatio(static_cast<float>(swapChain->GetVkExtent().width) / swapChain->GetVkExtent().height);
         renderer->RecreateFrameResources();
     }
 
@@ -116,7 +127,7 @@ namespace {
 				scene->theme.skyCol = glm::vec3(0.9, 0.665, 0.45) * 1.0f;
                 scene->theme.ambientScale = 1.0f;
                 scene->theme.ambientBlend = 0.7f;
-				renderer->reRecord = true;
+				scene->UpdateTheme();
 				break;
             }
             case GLFW_KEY_2:
@@ -130,7 +141,7 @@ namespace {
 				scene->theme.skyCol = glm::vec3(0.51, 0.665, 0.85) * 0.5f;
                 scene->theme.ambientScale = 2.5f;
                 scene->theme.ambientBlend = 0.7f;
-                renderer->reRecord = true;
+                scene->UpdateTheme();
 			    break;
             }
             case GLFW_KEY_3:
@@ -143,7 +154,7 @@ namespace {
                 scene->theme.skyCol = glm::vec3(0.41, 0.515, 0.55) * 1.8f;
                 scene->theme.ambientScale = 1.0f;
                 scene->theme.ambientBlend = 0.8f;
-                renderer->reRecord = true;
+                scene->UpdateTheme();
                 break;
             }
             case GLFW_KEY_4:
@@ -156,26 +167,28 @@ namespace {
                 scene->theme.skyCol = glm::vec3(0.41, 0.565, 0.75) * 1.99f;
                 scene->theme.ambientScale = 1.0f;
 				scene->theme.ambientBlend = 0.9f;
-                renderer->reRecord = true;
+                scene->UpdateTheme();
                 break;
             }
             case GLFW_KEY_R:
             {
-				renderer->renderReeds = !renderer->renderReeds;
-                renderer->reRecord = true;
+                Scene* scene = renderer->GetScene();
+                scene->theme.visibleMask ^= VISIBLE_REEDS;
+                scene->UpdateTheme();
                 break;
             }
             case GLFW_KEY_G:
             {
-                renderer->renderGrass = !renderer->renderGrass;
-                renderer->reRecord = true;
+                Scene* scene = renderer->GetScene();
+                scene->theme.visibleMask ^= VISIBLE_GRASS;
+                scene->UpdateTheme();
                 break;
             }
             case GLFW_KEY_C:
             {
                 Scene* scene = renderer->GetScene();
 				scene->theme.renderCloud = (scene->theme.renderCloud + 1) % 2;
-                renderer->reRecord = true;
+                scene->UpdateTheme();
                 break;
             }
             default:
@@ -183,11 +196,246 @@ namespace {
             }
 		}
 	}
+
+    // Terrain planes, grass and reeds as described by config
+    Scene* createScene(const SceneConfig& config, VkCommandPool transferCommandPool, VkImage grassImage, const SceneSnapshot* snapshot = nullptr) {
+        Scene* scene = new Scene(device);
+		setTheme(scene);
+		scene->UpdateTheme();
+        for (size_t b = 0; b < config.simulationBands.size(); ++b) {
+            scene->time.bandStart[b] = config.simulationBands[b];
+        }
+
+        const float planeDim = config.planeDim;
+        float halfWidth = planeDim * 0.5f;
+
+        glm::ivec2 terrainSize = { config.terrainWidth, config.terrainDepth };
+
+        // All grass tiles share one Blades so the renderer binds their buffers once per pass
+        std::vector<glm::vec3> grassTileOffsets;
+        for (int i = 0; i < terrainSize.x; ++i)
+        {
+            for (int j = 0; j < terrainSize.y; ++j)
+            {
+                glm::vec3 offset = { i * planeDim, 0, j * planeDim };
+                Model* plane = new Model(device, transferCommandPool,
+                    {
+                        { { -halfWidth + offset.x, 0.0f, halfWidth + offset.z }, { 1.0f, 0.0f, 0.0f },{ 1.0f, 0.0f } },
+                        { { halfWidth + offset.x, 0.0f, halfWidth + offset.z }, { 0.0f, 1.0f, 0.0f },{ 0.0f, 0.0f } },
+                        { { halfWidth + offset.x, 0.0f, -halfWidth + offset.z }, { 0.0f, 0.0f, 1.0f },{ 0.0f, 1.0f } },
+                        { { -halfWidth + offset.x, 0.0f, -halfWidth + offset.z }, { 1.0f, 1.0f, 1.0f },{ 1.0f, 1.0f } }
+                    },
+                    { 0, 1, 2, 2, 3, 0 }
+                );
+                plane->SetTexture(grassImage);
+                scene->AddModel(plane);
+
+                grassTileOffsets.push_back(offset);
+            }
+        }
+        if (!grassTileOffsets.empty()) {
+            scene->AddBlades(new Blades(device, transferCommandPool, planeDim, grassTileOffsets, config.grass, snapshot));
+        }
+
+        const int reedScale = static_cast<int>(config.reedScale);
+
+        std::vector<glm::vec3> reedTileOffsets;
+        for (int i = 0; i < terrainSize.x / reedScale; ++i)
+        {
+            for (int j = 0; j < terrainSize.y / reedScale; ++j)
+            {
+                glm::vec3 offset = { i * planeDim * reedScale + halfWidth * (reedScale - 1), 0, j * planeDim * reedScale + halfWidth * (reedScale - 1) };
+                reedTileOffsets.push_back(offset);
+            }
+        }
+        if (!reedTileOffsets.empty()) {
+            scene->AddReeds(new Reeds(device, transferCommandPool, planeDim * reedScale, reedTileOffsets, config.reeds, snapshot));
+        }
+
+        return scene;
+    }
+
+    // config.colliders test colliders, each circling its own patch of the terrain. Every other one is a
+    // capsule lying along its direction of travel
+    void moveColliders(Scene* scene, const SceneConfig& config) {
+        const uint32_t count = std::min(config.colliders, MAX_COLLIDERS);
+        const uint32_t side = static_cast<uint32_t>(std::ceil(std::sqrt(static_cast<float>(count))));
+        const glm::vec2 extent = glm::vec2(config.terrainWidth, config.terrainDepth) * config.planeDim;
+        const float radius = config.colliderRadius;
+
+        scene->colliders.resize(count);
+        for (uint32_t i = 0; i < count; ++i) {
+            glm::vec2 patch = extent / static_cast<float>(side);
+            glm::vec2 center = (glm::vec2(i % side, i / side) + 0.5f) * patch - config.planeDim * 0.5f;
+            float phase = scene->time.totalTime * 0.5f + static_cast<float>(i);
+            glm::vec2 xz = center + glm::vec2(std::cos(phase), std::sin(phase)) * patch * 0.3f;
+
+            glm::vec3 position(xz.x, terrainHeight(xz) + radius, xz.y);
+            glm::vec3 along = i % 2 == 1 ? glm::vec3(-std::sin(phase), 0.f, std::cos(phase)) * radius * 2.f : glm::vec3(0.f);
+
+            Collider& collider = scene->colliders[i];
+            collider.a = position - along;
+            collider.b = position + along;
+            collider.radius = radius;
+        }
+        scene->UpdateColliders();
+    }
+
+    // Memory allocations of one terrain plane Model: vertex, index and model buffers
+    constexpr uint32_t PLANE_ALLOCATIONS = 3;
+    // Allocations a scene makes besides its planes: blades, reeds, scene and renderer resources and a staging buffer
+    constexpr uint32_t SCENE_FIXED_ALLOCATIONS = 64;
+
+    // Render every configuration of config.sweep in turn and write one CSV row for each
+    void runSweep(const SceneConfig& config, VkCommandPool transferCommandPool, VkImage grassImage) {
+        typedef std::chrono::high_resolution_clock Clock;
+        const SweepSettings& sweep = config.sweep;
+
+        std::ofstream csv(sweep.output);
+        if (!csv) {
+            throw std::runtime_error("Failed to open sweep output " + sweep.output);
+        }
+
+        // Every plane is its own allocation, so large tile counts can run out before memory does
+        VkPhysicalDeviceProperties properties;
+        vkGetPhysicalDeviceProperties(device->GetInstance()->GetPhysicalDevice(), &properties);
+        const uint32_t maxAllocations = properties.limits.maxMemoryAllocationCount;
+
+        const std::vector<uint32_t> reedsPerSideList = sweep.reedsPerSide.empty() ? std::vector<uint32_t>{ config.reeds.reedsPerSide } : sweep.reedsPerSide;
+
+        csv << "tiles,blades_per_tile,total_blades,reeds_per_side,reed_tiles,startup_ms,device_memory_mb,peak_device_memory_mb,"
+               "cpu_frame_ms,cpu_wait_ms,cpu_record_ms,gpu_compute_ms,gpu_scene_ms,gpu_post_process_ms,gpu_frames,integrated_blades" << std::endl;
+
+        for (uint32_t tiles : sweep.tileCounts) {
+            for (uint32_t bladesPerTile : sweep.bladesPerTile) {
+                for (uint32_t reedsPerSide : reedsPerSideList) {
+                    // Lay the tiles out as close to square as possible
+                    SceneConfig run = config;
+                    run.terrainWidth = static_cast<uint32_t>(std::ceil(std::sqrt(static_cast<double>(tiles))));
+                    run.terrainDepth = (tiles + run.terrainWidth - 1) / run.terrainWidth;
+                    run.grass.bladesPerTile = bladesPerTile;
+                    run.reeds.reedsPerSide = reedsPerSide;
+
+                    const uint64_t tileCount = uint64_t(run.terrainWidth) * run.terrainDepth;
+                    const uint64_t totalBlades = tileCount * bladesPerTile;
+                    if (totalBlades > sweep.maxBlades) {
+                        std::cout << "Skipping " << tileCount << " tiles of " << bladesPerTile << " blades, over sweep_max_blades" << std::endl;
+                        continue;
+                    }
+                    const uint64_t allocations = device->GetAllocationCount() + tileCount * PLANE_ALLOCATIONS + SCENE_FIXED_ALLOCATIONS;
+                    if (allocations > maxAllocations) {
+                        std::cout << "Skipping " << tileCount << " tiles, needs about " << allocations << " memory allocations of the device's " << maxAllocations << std::endl;
+                        continue;
+                    }
+                    std::cout << "Sweeping " << tileCount << " tiles of " << bladesPerTile << " blades and " << reedsPerSide << "^2 reeds" << std::endl;
+
+                    // Startup covers blade generation, buffer uploads, pipeline creation and the warm start.
+                    // Memory is what the configuration keeps resident after it, and the most it held at once
+                    const VkDeviceSize residentBefore = device->GetResidentBytes();
+                    device->ResetPeakBytes();
+                    Clock::time_point startupStart = Clock::now();
+                    Scene* scene = createScene(run, transferCommandPool, grassImage);
+                    renderer = new Renderer(device, swapChain, scene, camera);
+                    renderer->WarmStart(run.warmStartSteps, run.warmStartStep);
+                    vkDeviceWaitIdle(device->GetVkDevice());
+                    std::chrono::duration<double, std::milli> startupTime = Clock::now() - startupStart;
+                    const VkDeviceSize resident = device->GetResidentBytes() - residentBefore;
+
+                    scene->BeginTime();
+                    for (uint32_t frame = 0; frame < sweep.warmupFrames; ++frame) {
+                        glfwPollEvents();
+                        scene->UpdateTime();
+                        moveColliders(scene, run);
+                        renderer->Frame();
+                    }
+
+                    renderer->ResetFrameTimings();
+                    Clock::time_point framesStart = Clock::now();
+                    for (uint32_t frame = 0; frame < sweep.frames; ++frame) {
+                        glfwPollEvents();
+                        scene->UpdateTime();
+                        moveColliders(scene, run);
+                        renderer->Frame();
+                    }
+                    vkDeviceWaitIdle(device->GetVkDevice());
+                    std::chrono::duration<double, std::milli> framesTime = Clock::now() - framesStart;
+                    const FrameTimings timings = renderer->GetFrameTimings();
+
+                    uint32_t reedTiles = 0;
+                    for (const Reeds* reeds : scene->GetReeds()) {
+                        reedTiles += reeds->GetTileCount();
+                    }
+
+                    csv << tileCount << ',' << bladesPerTile << ',' << totalBlades << ',' << reedsPerSide << ',' << reedTiles << ','
+                        << startupTime.count() << ',' << resident / (1024.0 * 1024.0) << ',' << (device->GetPeakBytes() - residentBefore) / (1024.0 * 1024.0) << ','
+                        << framesTime.count() / sweep.frames << ',' << timings.waitMs << ',' << timings.recordMs << ','
+                        << timings.computeMs << ',' << timings.sceneMs << ',' << timings.postProcessMs << ',' << timings.gpuFrames << ',' << timings.integratedBlades << std::endl;
+
+                    delete renderer;
+                    renderer = nullptr;
+                    delete scene;
+                }
+            }
+        }
+        std::cout << "Wrote " << sweep.output << std::endl;
+    }
+
+    void readGrass(Scene* scene, VkCommandPool transferCommandPool, std::vector<BladeStatic>& bladesStatic, std::vector<BladeDynamic>& bladesDynamic) {
+        vkDeviceWaitIdle(device->GetVkDevice());
+        bladesStatic.clear();
+        bladesDynamic.clear();
+        for (const Blades* blades : scene->GetBlades()) {
+            size_t first = bladesStatic.size();
+            size_t count = size_t(blades->GetTileCount()) * blades->GetBladesPerTile();
+            bladesStatic.resize(first + count);
+            bladesDynamic.resize(first + count);
+            BufferUtils::ReadBuffer(device, transferCommandPool, blades->GetBladesStaticBuffer(), &bladesStatic[first], count * sizeof(BladeStatic));
+            BufferUtils::ReadBuffer(device, transferCommandPool, blades->GetBladesDynamicBuffer(), &bladesDynamic[first], count * sizeof(BladeDynamic));
+        }
+    }
+
+    // Read the grass back around the warm start and write it to config.captureSimulation with the
+    // noise texture its wind comes from, the CPU simulation tests replay the same steps against it
+    void captureSimulation(const SceneConfig& config, VkCommandPool transferCommandPool, VkImage grassImage) {
+        Scene* scene = createScene(config, transferCommandPool, grassImage);
+        renderer = new Renderer(device, swapChain, scene, camera);
+
+        SimulationCapture capture;
+        capture.steps = config.warmStartSteps;
+        capture.stepSize = config.warmStartStep;
+        readGrass(scene, transferCommandPool, capture.bladesStatic, capture.before);
+        renderer->WarmStart(config.warmStartSteps, config.warmStartStep);
+        // Static blades don't change, they are only kept from the first read
+        std::vector<BladeStatic> unchanged;
+        readGrass(scene, transferCommandPool, unchanged, capture.after);
+
+        int width, height, channels;
+        stbi_uc* pixels = stbi_load("images/noiseTexture.png", &width, &height, &channels, STBI_rgb_alpha);
+        if (!pixels) {
+            throw std::runtime_error("Failed to load texture image");
+        }
+        capture.noiseWidth = static_cast<uint32_t>(width);
+        capture.noiseHeight = static_cast<uint32_t>(height);
+        capture.noiseRgba.assign(pixels, pixels + size_t(width) * height * 4);
+        stbi_image_free(pixels);
+
+        if (!capture.Write(config.captureSimulation)) {
+            throw std::runtime_error("Failed to write simulation capture " + config.captureSimulation);
+        }
+        std::cout << "Wrote simulation capture " << config.captureSimulation << " of " << capture.bladesStatic.size() << " blades" << std::endl;
+
+        delete renderer;
+        renderer = nullptr;
+        delete scene;
+    }
+
 }
 
-int main() {
+int main(int argc, char** argv) {
+    SceneConfig config = SceneConfig::Load(argc, argv);
+
     static constexpr char* applicationName = "Vulkan Grass Rendering";
-    InitializeWindow(1440, 1080, applicationName);
+    InitializeWindow(config.windowWidth, config.windowHeight, applicationName, !config.sweep.enabled && config.captureSimulation.empty());
 
     unsigned int glfwExtensionCount = 0;
     const char** glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
@@ -206,11 +454,18 @@ int main() {
     deviceFeatures.fillModeNonSolid = VK_TRUE;
     deviceFeatures.samplerAnisotropy = VK_TRUE;
 
+    // Reed variants and LODs are drawn with a single multi draw when available
+    VkPhysicalDeviceFeatures supportedFeatures;
+    vkGetPhysicalDeviceFeatures(instance->GetPhysicalDevice(), &supportedFeatures);
+    deviceFeatures.multiDrawIndirect = supportedFeatures.multiDrawIndirect;
+
     device = instance->CreateDevice(QueueFlagBit::GraphicsBit | QueueFlagBit::TransferBit | QueueFlagBit::ComputeBit | QueueFlagBit::PresentBit, deviceFeatures);
 
     swapChain = device->CreateSwapChain(surface, 3);
 
-    camera = new Camera(device, 640.f / 480.f);
+    // The swapchain may not match the requested window size exactly
+    const VkExtent2D extent = swapChain->GetVkExtent();
+    camera = new Camera(device, static_cast<float>(extent.width) / extent.height);
 
     VkCommandPoolCreateInfo transferPoolInfo = {};
     transferPoolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
@@ -236,112 +491,59 @@ int main() {
         grassImageMemory
     );
 
-	std::vector<ReedVertex> reedVertices;
-	std::vector<uint32_t> reedIndices;
-
-    {
-        std::string inputfile = "images/reed1.obj";
-        tinyobj::attrib_t attrib;
-        std::vector<tinyobj::shape_t> shapes;
-        std::vector<tinyobj::material_t> materials;
-
-        std::string err;
-
-        bool ret = tinyobj::LoadObj(&attrib, &shapes, &materials, &err, inputfile.c_str());
-
-        if (!ret)
-        {
-            std::cout << err << std::endl;
-            throw std::runtime_error("Failed to load reed object");
-        }
+	{
+		MeshCache reed0("images/reed.obj");
+		MeshCache reed1("images/reed1.obj");
+		MeshCache reed2("images/reed2.obj");
+		MeshCache reed3("images/reed3.obj");
+		Reed::CreateBladeVertexIndexBuffer(device, transferCommandPool, { &reed0, &reed1, &reed2, &reed3 });
+	}
 
-        size_t s = 0;
-        size_t index_offset = 0;
-        for (size_t f = 0; f < shapes[s].mesh.num_face_vertices.size(); f++) {
-            size_t fv = size_t(shapes[s].mesh.num_face_vertices[f]);
-
-            // Loop over vertices in the face.
-            for (size_t v = 0; v < fv; v++) {
-				reedIndices.push_back(index_offset + v);
-				ReedVertex vertex = {};
-                // access to vertex
-                tinyobj::index_t idx = shapes[s].mesh.indices[index_offset + v];
-
-                tinyobj::real_t vx = attrib.vertices[3 * size_t(idx.vertex_index) + 0] / 2.f;
-                tinyobj::real_t vy = attrib.vertices[3 * size_t(idx.vertex_index) + 1] / 2.f;
-                tinyobj::real_t vz = attrib.vertices[3 * size_t(idx.vertex_index) + 2] / 4.f;
-				//if (vy < 1.0) vz /= 2.f;
-				vertex.pos = glm::vec4(vx, vy, vz, 1.0f);
-
-                // Check if `normal_index` is zero or positive. negative = no normal data
-                if (idx.normal_index >= 0) {
-                    tinyobj::real_t nx = attrib.normals[3 * size_t(idx.normal_index) + 0];
-                    tinyobj::real_t ny = attrib.normals[3 * size_t(idx.normal_index) + 1];
-                    tinyobj::real_t nz = attrib.normals[3 * size_t(idx.normal_index) + 2];
-					vertex.normal = glm::vec4(nx, ny, nz, 0.0f);
-                }
+    Blade::CreateBladeVertexIndexBuffer(device, transferCommandPool);
 
-				reedVertices.push_back(vertex);
-            }
-            index_offset += fv;
+    if (config.sweep.enabled || !config.captureSimulation.empty()) {
+        if (config.sweep.enabled) {
+            runSweep(config, transferCommandPool, grassImage);
+        } else {
+            captureSimulation(config, transferCommandPool, grassImage);
         }
 
-		Reed::CreateBladeVertexIndexBuffer(device, transferCommandPool, reedVertices, reedIndices);
+        vkDestroyCommandPool(device->GetVkDevice(), transferCommandPool, nullptr);
+        vkDestroyImage(device->GetVkDevice(), grassImage, nullptr);
+        device->RecordFree(grassImageMemory);
+        vkFreeMemory(device->GetVkDevice(), grassImageMemory, nullptr);
+        Blade::DestroyBladeVertexIndexBuffer(device);
+        Reed::DestroyBladeVertexIndexBuffer(device);
+
+        delete camera;
+        delete swapChain;
+        delete device;
+        vkDestroySurfaceKHR(instance->GetVkInstance(), surface, nullptr);
+        delete instance;
+        DestroyWindow();
+        return 0;
     }
 
-    Scene* scene = new Scene(device);
-	setTheme(scene);
-
-    float planeDim = 15.f;
-    float halfWidth = planeDim * 0.5f;
-
-    glm::ivec2 terrainSize = { 20, 20 };
-
-    for (int i = 0; i < terrainSize.x; ++i)
-    {
-        for (int j = 0; j < terrainSize.y; ++j)
-        {
-            glm::vec3 offset = { i * planeDim, 0, j * planeDim };
-            Model* plane = new Model(device, transferCommandPool,
-                {
-                    { { -halfWidth + offset.x, 0.0f, halfWidth + offset.z }, { 1.0f, 0.0f, 0.0f },{ 1.0f, 0.0f } },
-                    { { halfWidth + offset.x, 0.0f, halfWidth + offset.z }, { 0.0f, 1.0f, 0.0f },{ 0.0f, 0.0f } },
-                    { { halfWidth + offset.x, 0.0f, -halfWidth + offset.z }, { 0.0f, 0.0f, 1.0f },{ 0.0f, 1.0f } },
-                    { { -halfWidth + offset.x, 0.0f, -halfWidth + offset.z }, { 1.0f, 1.0f, 1.0f },{ 1.0f, 1.0f } }
-                },
-                { 0, 1, 2, 2, 3, 0 }
-            );
-            plane->SetTexture(grassImage);
-            scene->AddModel(plane);
-
-
-			Blades* blades = new Blades(device, transferCommandPool, planeDim, offset);
-            scene->AddBlades(blades);
-
-        }
+    // A matching snapshot replaces blade generation, a missing or stale one is written once the blades exist
+    const uint64_t configHash = SceneSnapshot::HashConfig(config);
+    SceneSnapshot snapshot;
+    bool snapshotLoaded = !config.snapshot.empty() && snapshot.Open(config.snapshot, configHash);
+    if (snapshotLoaded) {
+        std::cout << "Loading blades from snapshot " << config.snapshot << (snapshot.IsSettled() ? " (settled)" : "") << std::endl;
     }
 
-    const int reedScale = 20;
+    Scene* scene = createScene(config, transferCommandPool, grassImage, snapshotLoaded ? &snapshot : nullptr);
 
-    for (int i = 0; i < terrainSize.x / reedScale; ++i)
-    {
-        for (int j = 0; j < terrainSize.y / reedScale; ++j)
-        {
-            glm::vec3 offset = { i * planeDim * reedScale + halfWidth * (reedScale - 1), 0, j * planeDim * reedScale + halfWidth * (reedScale - 1) };
-
-            Reeds* reeds = new Reeds(device, transferCommandPool, planeDim * reedScale, offset);
-            scene->AddReeds(reeds);
+    renderer = new Renderer(device, swapChain, scene, camera);
 
-        }
+    // Settled snapshots are already at rest, and new snapshots are taken after the warm start
+    const uint32_t warmStartSteps = snapshotLoaded && snapshot.IsSettled() ? 0 : config.warmStartSteps;
+    snapshot.Close();
+    renderer->WarmStart(warmStartSteps, config.warmStartStep);
+    if (!config.snapshot.empty() && !snapshotLoaded) {
+        SceneSnapshot::Write(device, transferCommandPool, scene, config.snapshot, configHash, warmStartSteps > 0);
     }
 
-    Blade::CreateBladeVertexIndexBuffer(device, transferCommandPool);
-
-    vkDestroyCommandPool(device->GetVkDevice(), transferCommandPool, nullptr);
-
-
-    renderer = new Renderer(device, swapChain, scene, camera);
-
     glfwSetWindowSizeCallback(GetGLFWWindow(), resizeCallback);
     glfwSetMouseButtonCallback(GetGLFWWindow(), mouseDownCallback);
     glfwSetCursorPosCallback(GetGLFWWindow(), mouseMoveCallback);
@@ -352,14 +554,22 @@ int main() {
     while (!ShouldQuit()) {
         glfwPollEvents();
         scene->UpdateTime();
+        moveColliders(scene, config);
         renderer->Frame();
         ++frames;
     }
 	std::cout << "Average frame time: " << scene->time.totalTime / (float)frames << std::endl;
+    std::cout << "Average blades integrated per frame: " << renderer->GetFrameTimings().integratedBlades << std::endl;
+
+    if (!config.snapshot.empty() && config.snapshotSettled) {
+        SceneSnapshot::Write(device, transferCommandPool, scene, config.snapshot, configHash, true);
+    }
+    vkDestroyCommandPool(device->GetVkDevice(), transferCommandPool, nullptr);
 
     vkDeviceWaitIdle(device->GetVkDevice());
 
     vkDestroyImage(device->GetVkDevice(), grassImage, nullptr);
+    device->RecordFree(grassImageMemory);
     vkFreeMemory(device->GetVkDevice(), grassImageMemory, nullptr);
 	Blade::DestroyBladeVertexIndexBuffer(device);
 	Reed::DestroyBladeVertexIndexBuffer(device);
@@ -0,0 +1,70 @@
+// Packed blade layout, keep in sync with core/BladePacking.h
+
+// v1 and v2 are stored relative to v0 as snorm16, scaled by this range
+const float BLADE_OFFSET_RANGE = 32.0f;
+
+// Attributes that never change after generation
+struct BladeStatic {
+    // Root position
+    vec3 v0;
+    // Direction and height (half2)
+    uint dirHeight;
+    // Width and stiffness coefficient (half2)
+    uint widthStiffness;
+    // Terrain normal at the root (octahedral, 2 x snorm16)
+    uint terrainNormal;
+    // Mesh variant, always 0 for grass
+    uint variant;
+};
+
+// State written by the simulation every frame
+struct BladeDynamic {
+    // xyz: v1 - v0 and v2 - v0 (6 x snorm16), w: sleep state owned by compute.comp, 0 is awake
+    uvec4 bezier;
+};
+
+// Culled lists store two 16-bit blade indices per uint
+uint culledIndexShift(uint slot)
+{
+    return (slot & 1u) * 16u;
+}
+
+// Tiles share one set of buffers, tile t owns slotsPerTile culled slots and bladesPerTile blades.
+// Culled entries are local to their tile, returns the blade index in the shared buffers
+uint culledBladeIndex(uint culledWord, uint slot, uint slotsPerTile, uint bladesPerTile)
+{
+    uint localIndex = (culledWord >> culledIndexShift(slot)) & 0xffffu;
+    return (slot / slotsPerTile) * bladesPerTile + localIndex;
+}
+
+uint packOctahedral(vec3 n)
+{
+    n /= abs(n.x) + abs(n.y) + abs(n.z);
+    vec2 p = n.z >= 0.0 ? n.xy : (1.0 - abs(n.yx)) * mix(vec2(-1.0), vec2(1.0), greaterThanEqual(n.xy, vec2(0.0)));
+    return packSnorm2x16(p);
+}
+
+vec3 unpackOctahedral(uint packed)
+{
+    vec2 p = unpackSnorm2x16(packed);
+    vec3 n = vec3(p, 1.0 - abs(p.x) - abs(p.y));
+    float t = max(-n.z, 0.0);
+    n.xy += mix(vec2(t), vec2(-t), greaterThanEqual(n.xy, vec2(0.0)));
+    return normalize(n);
+}
+
+uvec3 packBezier(vec3 v0, vec3 v1, vec3 v2)
+{
+    vec3 d1 = (v1 - v0) / BLADE_OFFSET_RANGE;
+    vec3 d2 = (v2 - v0) / BLADE_OFFSET_RANGE;
+    return uvec3(packSnorm2x16(d1.xy), packSnorm2x16(vec2(d1.z, d2.x)), packSnorm2x16(d2.yz));
+}
+
+void unpackBezier(uvec3 bezier, vec3 v0, out vec3 v1, out vec3 v2)
+{
+    vec2 a = unpackSnorm2x16(bezier.x) * BLADE_OFFSET_RANGE;
+    vec2 b = unpackSnorm2x16(bezier.y) * BLADE_OFFSET_RANGE;
+    vec2 c = unpackSnorm2x16(bezier.z) * BLADE_OFFSET_RANGE;
+    v1 = v0 + vec3(a, b.x);
+    v2 = v0 + vec3(b.y, c);
+}
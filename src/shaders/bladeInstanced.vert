@@ -1,12 +1,8 @@
 #version 450
 #extension GL_ARB_separate_shader_objects : enable
+#extension GL_GOOGLE_include_directive : require
 
-struct Blade {
-    vec4 v0;
-    vec4 v1;
-    vec4 v2;
-    vec4 up;
-};
+#include "blade.glsl"
 
 layout(set = 0, binding = 0) uniform CameraBufferObject {
     mat4 view;
@@ -20,10 +16,21 @@ layout(set = 1, binding = 0) uniform ModelBufferObject {
     mat4 model;
 };
 
-layout(set = 2, binding = 0) buffer CulledBladesBuffer {
-	Blade culledBlades[];
+layout(set = 2, binding = 0) readonly buffer CulledBladesBuffer {
+	uint culledIndices[];
 } culledBladesBuffer;
 
+layout(set = 3, binding = 0) readonly buffer BladesStaticBuffer {
+    BladeStatic blades[];
+} bladesStaticBuffer;
+
+layout(set = 3, binding = 1) readonly buffer BladesDynamicBuffer {
+    BladeDynamic blades[];
+} bladesDynamicBuffer;
+
+
+// Grass tile size from the scene config, set by the renderer
+layout(constant_id = 0) const uint BLADES_PER_TILE = 256;
 
 layout(location = 0) in vec2 uv;
 
@@ -31,6 +38,7 @@ layout(location = 0) out vec3 out_normal;
 layout(location = 1) out vec3 out_pos;
 layout(location = 2) out vec3 out_center;
 layout(location = 3) out vec3 out_uv;
+layout(location = 4) flat out vec3 out_terrainNormal;
 
 out gl_PerVertex {
     vec4 gl_Position;
@@ -114,14 +122,18 @@ vec3 slerp(in vec3 a, in vec3 b, in float t)
 void main()
 {
 
-    Blade blade = culledBladesBuffer.culledBlades[gl_InstanceIndex];
-    float angle = blade.v0.w;
-    float height = blade.v1.w;
-    float width = blade.v2.w;
+    uint slot = uint(gl_InstanceIndex);
+    // One draw per tile, each with a culled range as long as the tile
+    uint index = culledBladeIndex(culledBladesBuffer.culledIndices[slot >> 1], slot, BLADES_PER_TILE, BLADES_PER_TILE);
+    BladeStatic blade = bladesStaticBuffer.blades[index];
+    vec2 dirHeight = unpackHalf2x16(blade.dirHeight);
+    float angle = dirHeight.x;
+    float height = dirHeight.y;
+    float width = unpackHalf2x16(blade.widthStiffness).x;
 
-    vec3 v0 = blade.v0.xyz;
-    vec3 v1 = blade.v1.xyz;
-    vec3 v2 = blade.v2.xyz;
+    vec3 v0 = blade.v0;
+    vec3 v1, v2;
+    unpackBezier(bladesDynamicBuffer.blades[index].bezier.xyz, v0, v1, v2);
 
     vec3 a = v0 + uv.y * (v1 - v0);
     vec3 b = v1 + uv.y * (v2 - v1);
@@ -168,6 +180,7 @@ void main()
     out_normal = normal;
     out_pos = pos.xyz;
     out_center = c;
+    out_terrainNormal = unpackOctahedral(blade.terrainNormal);
     out_uv = vec3(uv, width);
 
     gl_Position = camera.proj * camera.view * pos;
@@ -0,0 +1,35 @@
+// Collider layout and grid, keep in sync with Scene.h and Renderer.cpp
+
+// Capsule between a and b, a sphere when they are equal
+struct Collider {
+    vec3 a;
+    float radius;
+    vec3 b;
+    float pad;
+};
+
+// Colliders are binned into square cells on xz. Cells wrap every COLLIDER_GRID_SIZE, so far apart
+// colliders may share a cell, which only costs extra tests
+const float COLLIDER_CELL_SIZE = 4.0f;
+const int COLLIDER_GRID_SIZE = 128;
+// Colliders past this many in one cell are dropped from it
+const uint MAX_COLLIDERS_PER_CELL = 16u;
+
+ivec2 colliderCellCoord(vec2 xz)
+{
+    return ivec2(floor(xz / COLLIDER_CELL_SIZE));
+}
+
+uint colliderCellIndex(ivec2 coord)
+{
+    ivec2 wrapped = coord & (COLLIDER_GRID_SIZE - 1);
+    return uint(wrapped.y * COLLIDER_GRID_SIZE + wrapped.x);
+}
+
+// Closest point to p on the collider's axis
+vec3 colliderAxisPoint(Collider collider, vec3 p)
+{
+    vec3 axis = collider.b - collider.a;
+    float t = clamp(dot(p - collider.a, axis) / max(dot(axis, axis), 1e-6f), 0.f, 1.f);
+    return collider.a + t * axis;
+}
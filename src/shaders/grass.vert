@@ -1,15 +1,22 @@
 
 #version 450
 #extension GL_ARB_separate_shader_objects : enable
+#extension GL_GOOGLE_include_directive : require
+
+#include "blade.glsl"
 
 layout(set = 1, binding = 0) uniform ModelBufferObject {
     mat4 model;
 };
 
-layout(location = 0) in vec4 v0;
-layout(location = 1) in vec4 v1;
-layout(location = 2) in vec4 v2;
-layout(location = 3) in vec4 up;
+// Packed blade, see blade.glsl. The snorm offsets are already unpacked by the vertex fetch
+// Binding 0: BladeStatic
+layout(location = 0) in vec3 v0;
+layout(location = 1) in vec2 dirHeight;
+layout(location = 2) in vec2 widthStiffness;
+// Binding 1: BladeDynamic
+layout(location = 3) in vec4 bezierA;
+layout(location = 4) in vec2 bezierB;
 
 layout(location = 0) out vec4 tc_v0;
 layout(location = 1) out vec4 tc_v1;
@@ -21,9 +28,12 @@ out gl_PerVertex {
 };
 
 void main() {
-    gl_Position = model * vec4(v0.xyz, 1.f);
-	tc_v0 = model * v0;
-	tc_v1 = model * v1;
-	tc_v2 = model * v2;
-	tc_up = model * up;
+    vec3 v1 = v0 + bezierA.xyz * BLADE_OFFSET_RANGE;
+    vec3 v2 = v0 + vec3(bezierA.w, bezierB) * BLADE_OFFSET_RANGE;
+
+    gl_Position = model * vec4(v0, 1.f);
+	tc_v0 = vec4((model * vec4(v0, 1.f)).xyz, dirHeight.x);
+	tc_v1 = vec4((model * vec4(v1, 1.f)).xyz, dirHeight.y);
+	tc_v2 = vec4((model * vec4(v2, 1.f)).xyz, widthStiffness.x);
+	tc_up = vec4(normalize(mat3(model) * vec3(0.f, 1.f, 0.f)), widthStiffness.y);
 }
@@ -23,7 +23,8 @@ layout(location = 0) in vec2 fragTexCoord;
 
 layout(location = 0) out vec4 outColor;
 
-layout( push_constant ) uniform theme
+// Lives next to Time, keep in sync with Theme in Scene.h
+layout(set = 2, binding = 1) uniform ThemeBufferObject
 {
 	vec3 reedCol;
     uint renderCloud;
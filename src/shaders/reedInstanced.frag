@@ -13,10 +13,12 @@ layout(location = 0) in vec3 normal;
 layout(location = 1) in vec3 pos;
 layout(location = 2) in vec3 center;
 layout(location = 3) in vec2 uv;
+layout(location = 4) flat in vec3 terrainNor;
 
 layout(location = 0) out vec4 outColor;
 
-layout( push_constant ) uniform theme
+// Lives next to Time, keep in sync with Theme in Scene.h
+layout(set = 2, binding = 1) uniform ThemeBufferObject
 {
 	vec3 reedCol;
     float pad0;
@@ -34,79 +36,6 @@ vec3 IntegerToColor(uint val)
   return vec3(sin(freq * val) * .5 + .5);
 }
 
-// ref: https://github.com/ashima/webgl-noise/blob/master/src/noise2D.glsl
-vec3 mod289(vec3 x) {
-  return x - floor(x * (1.0 / 289.0)) * 289.0;
-}
-
-vec2 mod289(vec2 x) {
-  return x - floor(x * (1.0 / 289.0)) * 289.0;
-}
-
-vec3 permute(vec3 x) {
-  return mod289(((x*34.0)+10.0)*x);
-}
-
-float snoise(vec2 v)
-  {
-  const vec4 C = vec4(0.211324865405187,  // (3.0-sqrt(3.0))/6.0
-                      0.366025403784439,  // 0.5*(sqrt(3.0)-1.0)
-                     -0.577350269189626,  // -1.0 + 2.0 * C.x
-                      0.024390243902439); // 1.0 / 41.0
-// First corner
-  vec2 i  = floor(v + dot(v, C.yy) );
-  vec2 x0 = v -   i + dot(i, C.xx);
-
-// Other corners
-  vec2 i1;
-  i1 = (x0.x > x0.y) ? vec2(1.0, 0.0) : vec2(0.0, 1.0);
-  vec4 x12 = x0.xyxy + C.xxzz;
-  x12.xy -= i1;
-
-// Permutations
-  i = mod289(i); // Avoid truncation effects in permutation
-  vec3 p = permute( permute( i.y + vec3(0.0, i1.y, 1.0 ))
-		+ i.x + vec3(0.0, i1.x, 1.0 ));
-
-  vec3 m = max(0.5 - vec3(dot(x0,x0), dot(x12.xy,x12.xy), dot(x12.zw,x12.zw)), 0.0);
-  m = m*m ;
-  m = m*m ;
-
-// Gradients: 41 points uniformly over a line, mapped onto a diamond.
-// The ring size 17*17 = 289 is close to a multiple of 41 (41*7 = 287)
-
-  vec3 x = 2.0 * fract(p * C.www) - 1.0;
-  vec3 h = abs(x) - 0.5;
-  vec3 ox = floor(x + 0.5);
-  vec3 a0 = x - ox;
-
-// Normalise gradients implicitly by scaling m
-// Approximation of: m *= inversesqrt( a0*a0 + h*h );
-  m *= 1.79284291400159 - 0.85373472095314 * ( a0*a0 + h*h );
-
-// Compute final noise value at P
-  vec3 g;
-  g.x  = a0.x  * x0.x  + h.x  * x0.y;
-  g.yz = a0.yz * x12.xz + h.yz * x12.yw;
-  return 130.0 * dot(m, g);
-}
-
-float terrainHeight(vec2 v)
-{
-	return snoise(v * 0.01f) * 10.f;
-}
-
-vec3 normalFromTerrain(float x, float y)
-{
-    // sample the height map
-    float eps  = 0.01f;
-    float fx0 = terrainHeight(vec2(x-eps,y)), fx1 = terrainHeight(vec2(x+eps,y));
-    float fy0 = terrainHeight(vec2(x,y-eps)), fy1 = terrainHeight(vec2(x,y+eps));
-
-    vec3 n = normalize(vec3((fx0 - fx1)/(1.0*eps), 1, (fy0 - fy1)/(1.0*eps)));
-    return n;
-}
-
 vec3 calNormal(vec3 pos)
 {
 	vec3 X = dFdx ( pos );
@@ -128,7 +57,6 @@ void main() {
     if (nor.y < 0.0) nor = -nor;
     bool isLeaf = uv.y > 1.f;
     
-    vec3 terrainNor = normalFromTerrain(pos.x, pos.z);
 
     vec3 baseCol = isLeaf ? Theme.reedCol : vec3(0.24, 0.45, 0.23) * 0.7;
     float terrainDiffuse = clamp(dot(terrainNor, -lightDir), 0.f, 1.f);
@@ -1,12 +1,8 @@
 #version 450
 #extension GL_ARB_separate_shader_objects : enable
+#extension GL_GOOGLE_include_directive : require
 
-struct Blade {
-    vec4 v0;
-    vec4 v1;
-    vec4 v2;
-    vec4 up;
-};
+#include "blade.glsl"
 
 layout(set = 0, binding = 0) uniform CameraBufferObject {
     mat4 view;
@@ -16,8 +12,8 @@ layout(set = 0, binding = 0) uniform CameraBufferObject {
     vec4 eye;
 } camera;
 
-layout(set = 1, binding = 0) buffer CulledBladesBuffer {
-	Blade culledBlades[];
+layout(set = 1, binding = 0) readonly buffer CulledBladesBuffer {
+	uint culledIndices[];
 } culledBladesBuffer;
 
 layout(set = 2, binding = 0) uniform Time {
@@ -25,16 +21,37 @@ layout(set = 2, binding = 0) uniform Time {
     float totalTime;
 } time;
 
-layout(set = 3, binding = 0) uniform sampler2D noiseSampler;
+// Written by wind.comp before the frame
+layout(set = 3, binding = 1) uniform sampler2DArray windField;
+
+// Keep in sync with wind.comp
+const int WIND_LAYER_LEAVES = 2;
+
+layout(set = 4, binding = 0) readonly buffer BladesStaticBuffer {
+    BladeStatic blades[];
+} bladesStaticBuffer;
+
+layout(set = 4, binding = 1) readonly buffer BladesDynamicBuffer {
+    BladeDynamic blades[];
+} bladesDynamicBuffer;
 
 
-layout(location = 0) in vec4 in_pos;
+// Keep in sync with Reeds.h, set by the renderer
+layout(constant_id = 0) const uint REED_DRAW_CAPACITY = 4096;
+layout(constant_id = 1) const uint REED_LOD_COUNT = 4;
+layout(constant_id = 2) const uint REEDS_PER_TILE = 4096;
+layout(constant_id = 3) const uint REED_DRAW_COUNT = 16;
+// Leaves of coarser LODs stay still
+const uint REED_WAVING_MAX_LOD = 1;
+
+layout(location = 0) in vec4 in_pos; // w: leaf id
 layout(location = 1) in vec4 in_normal;
 
 layout(location = 0) out vec3 out_normal;
 layout(location = 1) out vec3 out_pos;
 layout(location = 2) out vec3 out_center;
 layout(location = 3) out vec2 out_uv;
+layout(location = 4) flat out vec3 out_terrainNormal;
 
 out gl_PerVertex {
     vec4 gl_Position;
@@ -133,13 +150,6 @@ float uintHash(uint seed)
     return uintBitsToFloat(0x3f800000 | (seed >> 9)) - 1.0f;
 }
 
-vec3 perlin2DTex(vec2 p)
-{
-    p = fract(p);
-    vec3 val = texture(noiseSampler, p).rgb;
-    return 2.0 * (val - 0.5);
-}
-
 mat3 rotationMatrix(vec3 axis, float angle)
 {
     axis = normalize(axis);
@@ -170,14 +180,17 @@ vec3 calCurveNormal(in vec3 v0, in vec3 v1, in vec3 v2, in vec3 sNor, float t)
 void main()
 {
     
-    Blade blade = culledBladesBuffer.culledBlades[gl_InstanceIndex];
-    float angle = blade.v0.w;
-    float height = blade.v1.w;
-    float width = blade.v2.w;
-
-    vec3 v0 = blade.v0.xyz;
-    vec3 v1 = blade.v1.xyz;
-    vec3 v2 = blade.v2.xyz;
+    uint slot = uint(gl_InstanceIndex);
+    uint index = culledBladeIndex(culledBladesBuffer.culledIndices[slot >> 1], slot, REED_DRAW_CAPACITY * REED_DRAW_COUNT, REEDS_PER_TILE);
+    BladeStatic blade = bladesStaticBuffer.blades[index];
+    vec2 dirHeight = unpackHalf2x16(blade.dirHeight);
+    float angle = dirHeight.x;
+    float height = dirHeight.y;
+    float width = unpackHalf2x16(blade.widthStiffness).x;
+
+    vec3 v0 = blade.v0;
+    vec3 v1, v2;
+    unpackBezier(bladesDynamicBuffer.blades[index].bezier.xyz, v0, v1, v2);
     vec3 xzOffset = vec3(v2.x - v0.x, 0, v2.z - v0.z) * 0.2;
     //v1 += xzOffset;
     v1.y += height * 0.3;
@@ -240,18 +253,20 @@ void main()
     pos += height * (in_pos.z * bitangent + in_pos.x * cNor);
 
     // leaf waving
-    uint leafID = gl_VertexIndex / 36;
-    if (leafID > 0)
+    uint leafID = uint(in_pos.w);
+    uint lod = (slot / REED_DRAW_CAPACITY) % REED_LOD_COUNT;
+    if (leafID > 0 && lod <= REED_WAVING_MAX_LOD)
     {
         float leafHash = uintHash(leafID);
         float uvy = max(0.0, in_pos.y - 1.0);
-        vec3 offset = perlin2DTex(leafHash + pos.xz * 0.0005 + 0.01 * time.totalTime).xyz * uvy * 5.0;
+        vec3 offset = texture(windField, vec3(fract(leafHash + pos.xz * 0.0005), WIND_LAYER_LEAVES)).xyz * uvy * 5.0;
         pos += offset * vec3(0.1, 1.0, 0.1);
     }
     
     out_normal = rot * rotation * vec3(in_normal);
     out_pos = pos.xyz;
     out_center = c;
+    out_terrainNormal = unpackOctahedral(blade.terrainNormal);
     out_uv = in_pos.xy;
 
     gl_Position = camera.proj * camera.view * vec4(pos, 1.f);
@@ -0,0 +1,157 @@
+// Checks of the CPU grass simulation, no GPU needed. Exits non-zero on a mismatch.
+//   grass_simulation_test simd                 SSE2 Simulate against SimulateScalar on random batches
+//   grass_simulation_test golden <capture>     replay a GPU capture on the CPU and compare the result
+//
+// The capture is written by the renderer from the scene in capture.cfg, run from the build's src directory:
+//   vulkan_grass_rendering --config=<repo>/src/tests/capture.cfg --capture_simulation=<repo>/src/tests/data/simulation_capture.bin
+// Regenerate it whenever compute.comp, wind.comp, blade generation or the blade layout changes.
+// CMake registers the golden test once data/simulation_capture.bin exists. Set GOLDEN_TOLERANCE from the
+// difference the first capture reports, with some margin, when committing it
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "GrassSimulation.h"
+#include "SimulationCapture.h"
+
+namespace {
+    // SSE and scalar paths may round a result to neighbouring snorm16 steps, which then feeds the next step
+    const float SIMD_TOLERANCE = 4.f * BLADE_OFFSET_RANGE / 32767.f;
+    // The GPU samples wind from a half float field built from the noise rather than the noise itself.
+    // Provisional until a capture is committed, see the top of this file
+    const float GOLDEN_TOLERANCE = 0.05f;
+
+    GrassSimulation::NoiseField RandomNoise(std::mt19937& rng) {
+        std::uniform_int_distribution<int> byte(0, 255);
+        std::vector<uint8_t> rgba(64 * 64 * 4);
+        for (uint8_t& texel : rgba) {
+            texel = static_cast<uint8_t>(byte(rng));
+        }
+        return GrassSimulation::NoiseField(64, 64, rgba.data());
+    }
+
+    // Blades bent in random directions over a large patch, with some unused slots among them
+    GrassSimulation::BladeBatch RandomBatch(std::mt19937& rng, size_t count) {
+        std::uniform_real_distribution<float> position(-200.f, 200.f);
+        std::uniform_real_distribution<float> unit(0.f, 1.f);
+
+        GrassSimulation::BladeBatch batch;
+        batch.Resize(count);
+        for (size_t i = 0; i < count; ++i) {
+            float height = unit(rng) < 0.1f ? 0.f : 0.5f + 2.f * unit(rng);
+            float direction = 6.2831853f * unit(rng);
+            float bend = 0.8f * unit(rng) * height;
+            float bendDirection = 6.2831853f * unit(rng);
+
+            batch.v0x[i] = position(rng);
+            batch.v0y[i] = 0.5f * unit(rng);
+            batch.v0z[i] = position(rng);
+            batch.v1x[i] = batch.v0x[i];
+            batch.v1y[i] = batch.v0y[i] + 0.5f * height;
+            batch.v1z[i] = batch.v0z[i];
+            batch.v2x[i] = batch.v0x[i] + bend * std::cos(bendDirection);
+            batch.v2y[i] = batch.v0y[i] + height - 0.5f * bend;
+            batch.v2z[i] = batch.v0z[i] + bend * std::sin(bendDirection);
+            batch.height[i] = height;
+            batch.stiffness[i] = 0.5f + 2.5f * unit(rng);
+            batch.norx[i] = -std::sin(direction);
+            batch.norz[i] = std::cos(direction);
+        }
+        return batch;
+    }
+
+    // Largest difference between the control points of two batches, with the blade it occurs at
+    float MaxError(const GrassSimulation::BladeBatch& a, const GrassSimulation::BladeBatch& b, size_t& worst) {
+        float maxError = 0.f;
+        for (size_t i = 0; i < a.Size(); ++i) {
+            float error = std::max({
+                std::abs(a.v1x[i] - b.v1x[i]), std::abs(a.v1y[i] - b.v1y[i]), std::abs(a.v1z[i] - b.v1z[i]),
+                std::abs(a.v2x[i] - b.v2x[i]), std::abs(a.v2y[i] - b.v2y[i]), std::abs(a.v2z[i] - b.v2z[i]) });
+            if (error > maxError) {
+                maxError = error;
+                worst = i;
+            }
+        }
+        return maxError;
+    }
+
+    int TestSimd() {
+        const GrassSimulation::WindParams winds[] = { GrassSimulation::WindParams(), GrassSimulation::WindParams::ForReeds() };
+        // Sizes around the 4 wide SSE loop, so the scalar remainder is covered too
+        const size_t sizes[] = { 1, 3, 4, 5, 8, 255, 1026 };
+
+        int failures = 0;
+        for (uint32_t seed = 1; seed <= 4; ++seed) {
+            for (size_t size : sizes) {
+                for (const GrassSimulation::WindParams& wind : winds) {
+                    std::mt19937 rng(seed);
+                    GrassSimulation::NoiseField noise = RandomNoise(rng);
+                    GrassSimulation::BladeBatch simd = RandomBatch(rng, size);
+                    GrassSimulation::BladeBatch scalar = simd;
+
+                    float totalTime = 0.f;
+                    for (int step = 0; step < 10; ++step) {
+                        totalTime += 0.016f;
+                        GrassSimulation::Simulate(simd, wind, noise, 0.016f, totalTime);
+                        GrassSimulation::SimulateScalar(scalar, 0, scalar.Size(), wind, noise, 0.016f, totalTime);
+                    }
+
+                    size_t worst = 0;
+                    float error = MaxError(simd, scalar, worst);
+                    if (!(error <= SIMD_TOLERANCE)) {
+                        std::printf("simd: seed %u, %zu blades, blade %zu differs by %g\n", seed, size, worst, error);
+                        ++failures;
+                    }
+                }
+            }
+        }
+        std::printf("simd: %s\n", failures == 0 ? "passed" : "FAILED");
+        return failures == 0 ? 0 : 1;
+    }
+
+    int TestGolden(const std::string& path) {
+        SimulationCapture capture;
+        if (!capture.Read(path)) {
+            std::printf("golden: %s is missing, truncated or from another capture version\n", path.c_str());
+            return 1;
+        }
+
+        const size_t count = capture.bladesStatic.size();
+        GrassSimulation::NoiseField noise(capture.noiseWidth, capture.noiseHeight, capture.noiseRgba.data());
+        GrassSimulation::BladeBatch cpu;
+        cpu.Load(capture.bladesStatic.data(), capture.before.data(), count);
+        GrassSimulation::BladeBatch gpu;
+        gpu.Load(capture.bladesStatic.data(), capture.after.data(), count);
+
+        // The warm start holds the wind at time zero
+        for (uint32_t step = 0; step < capture.steps; ++step) {
+            GrassSimulation::Simulate(cpu, GrassSimulation::WindParams(), noise, capture.stepSize, 0.f);
+        }
+
+        size_t worst = 0;
+        float error = MaxError(cpu, gpu, worst);
+        std::printf("golden: %zu blades over %u steps, largest difference %g at blade %zu\n", count, capture.steps, error, worst);
+        if (!(error <= GOLDEN_TOLERANCE)) {
+            std::printf("golden: FAILED, over %g\n", GOLDEN_TOLERANCE);
+            return 1;
+        }
+        std::printf("golden: passed\n");
+        return 0;
+    }
+}
+
+int main(int argc, char** argv) {
+    std::string test = argc > 1 ? argv[1] : "";
+    if (test == "simd" && argc == 2) {
+        return TestSimd();
+    }
+    if (test == "golden" && argc == 3) {
+        return TestGolden(argv[2]);
+    }
+    std::fprintf(stderr, "usage: grass_simulation_test simd | golden <capture>\n");
+    return 2;
+}